@@ -2470,6 +2470,11 @@ extern bool regexNeedsMultilineBuffer (struct lregexControlBlock *lcb)
 		return false;
 }
 
+extern bool regexHasSingleLinePatterns (struct lregexControlBlock *lcb)
+{
+	return ptrArrayCount(lcb->entries [REG_PARSER_SINGLE_LINE]) > 0;
+}
+
 extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString* const allLines)
 {
 	bool result = false;
@@ -98,6 +98,7 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 							  bool *disabled,
 							  void * userData);
 extern bool regexNeedsMultilineBuffer (struct lregexControlBlock *lcb);
+extern bool regexHasSingleLinePatterns (struct lregexControlBlock *lcb);
 extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString* const allLines);
 extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString* const allLines);
 
@@ -473,6 +473,42 @@ unsigned char *mio_memory_get_data (MIO *mio, size_t *size)
 	return ptr;
 }
 
+/**
+ * mio_memory_peek_line:
+ * @mio: A #MIO object
+ * @length: (out): Return location for the length of the line
+ *
+ * Gets the next line of a #MIO memory stream without copying it and without
+ * moving the stream position. The line includes its terminating new-line
+ * character, if any. Use mio_seek() with %SEEK_CUR and @length to consume
+ * the line.
+ *
+ * <warning><para>The returned pointer is only valid as long as the memory of
+ * the stream is.</para></warning>
+ *
+ * Returns: A pointer into the memory buffer of the stream, or %NULL if the
+ *          stream is not a memory stream, a character was pushed back with
+ *          mio_ungetc() or the end of the stream is reached.
+ */
+const unsigned char *mio_memory_peek_line (MIO *mio, size_t *length)
+{
+	const unsigned char *line;
+	const unsigned char *newline;
+	size_t left;
+
+	if (mio->type != MIO_TYPE_MEMORY ||
+		mio->impl.mem.ungetch != EOF ||
+		mio->impl.mem.pos >= mio->impl.mem.size)
+		return NULL;
+
+	line = mio->impl.mem.buf + mio->impl.mem.pos;
+	left = mio->impl.mem.size - mio->impl.mem.pos;
+	newline = memchr (line, '\n', left);
+	*length = newline ? (size_t)(newline - line) + 1 : left;
+
+	return line;
+}
+
 /**
  * mio_unref:
  * @mio: A #MIO object
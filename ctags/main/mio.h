@@ -129,6 +129,7 @@ MIO *mio_ref        (MIO *mio);
 int mio_unref (MIO *mio);
 FILE *mio_file_get_fp (MIO *mio);
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size);
+const unsigned char *mio_memory_peek_line (MIO *mio, size_t *length);
 size_t mio_read (MIO *mio,
 				 void *ptr,
 				 size_t size,
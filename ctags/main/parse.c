@@ -4265,6 +4265,11 @@ extern bool hasLanguageMultilineRegexPatterns (const langType language)
 	return lregexQueryParserAndSubparsers (language, regexNeedsMultilineBuffer);
 }
 
+extern bool hasLanguageSingleLineRegexPatterns (const langType language)
+{
+	return lregexQueryParserAndSubparsers (language, regexHasSingleLinePatterns);
+}
+
 
 extern void addLanguageCallbackRegex (const langType language, const char *const regex, const char *const flags,
 									  const regexCallback callback, bool *disabled, void *userData)
@@ -152,6 +152,7 @@ extern bool doesLanguageExpectCorkInRegex (const langType language);
 
 /* Multiline Regex Interface */
 extern bool hasLanguageMultilineRegexPatterns (const langType language);
+extern bool hasLanguageSingleLineRegexPatterns (const langType language);
 extern void matchLanguageMultilineRegex (const langType language, const vString* const allLines);
 extern void matchLanguageMultitableRegex (const langType language, const vString* const allLines);
 
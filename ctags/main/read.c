@@ -87,6 +87,12 @@ typedef struct sInputFile {
 	vString    *path;          /* path of input file (if any) */
 	vString    *line;          /* last line read from file */
 	const unsigned char* currentLine;  /* current line being worked on */
+	const unsigned char* currentLineStart; /* start of the current line */
+	const unsigned char* currentLineEnd;   /* end of the current line if it
+											  points into the input buffer
+											  rather than into `line' */
+	langType   singleLineRegexLang; /* language singleLineRegex is for */
+	bool       singleLineRegex;     /* it has single line regex patterns */
 	MIO        *mio;           /* MIO stream used for reading the file */
 	compoundPos    filePosition;  /* file position of current line */
 	unsigned int ungetchIdx;
@@ -147,7 +153,7 @@ extern unsigned long getInputLineNumber (void)
 
 extern int getInputLineOffset (void)
 {
-	unsigned char *base = (unsigned char *) vStringValue (File.line);
+	const unsigned char *base = File.currentLineStart;
 	int ret = File.currentLine - base - File.ungetchIdx;
 	return ret >= 0 ? ret : 0;
 }
@@ -738,6 +744,9 @@ extern bool openInputFile (const char *const fileName, const langType language,
 		mio_getpos (File.mio, &File.filePosition.pos);
 		File.filePosition.offset = StartOfLine.offset = mio_tell (File.mio);
 		File.currentLine  = NULL;
+		File.currentLineStart = NULL;
+		File.currentLineEnd = NULL;
+		File.singleLineRegexLang = LANG_IGNORE;
 
 		if (File.line != NULL)
 			vStringClear (File.line);
@@ -776,6 +785,9 @@ extern void resetInputFile (const langType language)
 	mio_getpos (File.mio, &File.filePosition.pos);
 	File.filePosition.offset = StartOfLine.offset = mio_tell (File.mio);
 	File.currentLine  = NULL;
+	File.currentLineStart = NULL;
+	File.currentLineEnd = NULL;
+	File.singleLineRegexLang = LANG_IGNORE;
 
 	if (File.line != NULL)
 		vStringClear (File.line);
@@ -847,12 +859,33 @@ typedef enum eEolType {
 
 static eolType readLine (vString *const vLine, MIO *const mio)
 {
+	const unsigned char *line;
 	char *str;
 	size_t size;
 	eolType r = eol_nl;
 
 	vStringClear (vLine);
 
+	/* Memory-backed input: copy the whole line at once instead of growing
+	 * the buffer around mio_gets(). Lines with NUL bytes take the slow path
+	 * which truncates them like fgets() would. */
+	line = mio_memory_peek_line (mio, &size);
+	if (line != NULL && memchr (line, '\0', size) == NULL)
+	{
+		vStringNCatSUnsafe (vLine, (const char *) line, size);
+		mio_seek (mio, (long) size, SEEK_CUR);
+
+		if (vStringLast (vLine) != '\n')
+			return eol_eof;
+		if (size > 1 && vStringChar (vLine, size - 2) == '\r')
+		{
+			vStringChar (vLine, size - 2) = '\n';
+			vStringChop (vLine);
+			return eol_cr_nl;
+		}
+		return eol_nl;
+	}
+
 	str = vStringValue (vLine);
 	size = vStringSize (vLine);
 
@@ -918,6 +951,9 @@ static vString *iFileGetLine (bool chop_newline)
 		if (File.allLines)
 			vStringCat (File.allLines, File.line);
 
+		File.currentLineStart = (const unsigned char *) vStringValue (File.line);
+		File.currentLineEnd = NULL;
+
 		bool chopped = vStringStripNewline (File.line);
 
 		matchLanguageRegex (lang, File.line);
@@ -943,6 +979,53 @@ static vString *iFileGetLine (bool chop_newline)
 	}
 }
 
+/*  Zero-copy variant of iFileGetLine () for getcFromInputFile (): points the
+ *  current line straight into the buffer of a memory-backed input stream.
+ *  Returns false, without consuming anything, when the line has to go through
+ *  File.line instead because it must be rewritten (CR-LF), contains NUL bytes
+ *  or is needed as a vString (regex patterns, #line directives).
+ */
+static bool iFileGetLineView (void)
+{
+	const unsigned char *line;
+	size_t len;
+
+	if (File.allLines)
+		return false;
+
+	line = mio_memory_peek_line (File.mio, &len);
+	if (line == NULL)
+		return false;
+	if (len > 1 && line[len - 1] == '\n' && line[len - 2] == '\r')
+		return false;
+	if (Option.lineDirectives && line[0] == '#')
+		return false;
+	if (memchr (line, '\0', len) != NULL)
+		return false;
+
+	/* Looking up the patterns of the parser and its subparsers is too
+	 * expensive for every line */
+	if (File.singleLineRegexLang != getInputLanguage ())
+	{
+		File.singleLineRegexLang = getInputLanguage ();
+		File.singleLineRegex = hasLanguageSingleLineRegexPatterns (File.singleLineRegexLang);
+	}
+	if (File.singleLineRegex)
+		return false;
+
+	mio_seek (File.mio, (long) len, SEEK_CUR);
+
+	/* Use StartOfLine from previous line and store it for the next one */
+	fileNewline (false);
+	mio_getpos (File.mio, &StartOfLine.pos);
+	StartOfLine.offset = mio_tell (File.mio);
+
+	File.currentLine = line;
+	File.currentLineStart = line;
+	File.currentLineEnd = line + len;
+	return true;
+}
+
 /*  Do not mix use of readLineFromInputFile () and getcFromInputFile () for the same file.
  */
 extern int getcFromInputFile (void)
@@ -962,10 +1045,15 @@ extern int getcFromInputFile (void)
 	{
 		if (File.currentLine != NULL)
 		{
-			c = *File.currentLine++;
+			if (File.currentLine == File.currentLineEnd)
+				c = '\0';
+			else
+				c = *File.currentLine++;
 			if (c == '\0')
 				File.currentLine = NULL;
 		}
+		else if (iFileGetLineView ())
+			c = '\0';
 		else
 		{
 			vString* const line = iFileGetLine (false);
@@ -985,7 +1073,7 @@ extern int getcFromInputFile (void)
  * be accessed.  Note that this can't access previous line data. */
 extern int getNthPrevCFromInputFile (unsigned int nth, int def)
 {
-	const unsigned char *base = (unsigned char *) vStringValue (File.line);
+	const unsigned char *base = File.currentLineStart;
 	const unsigned int offset = File.ungetchIdx + 1 + nth;
 
 	if (File.currentLine != NULL && File.currentLine >= base + offset)
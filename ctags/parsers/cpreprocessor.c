@@ -1656,7 +1656,10 @@ process:
 				if (directive)
 				{
 					ignore = handleDirective (c, &macroCorkIndex);
+					/* Collecting the body of every macro is wasted work
+					 * (and allocations) unless the field is wanted. */
 					if (Cpp.macrodefFieldIndex != FIELD_UNKNOWN
+						&& isFieldEnabled (Cpp.macrodefFieldIndex)
 						&& macroCorkIndex != CORK_NIL
 						&& macrodef == NULL)
 						macrodef = vStringNew ();
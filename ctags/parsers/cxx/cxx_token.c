@@ -61,6 +61,7 @@ void cxxTokenAPIInit(void)
 		(objPoolCreateFunc)createToken, (objPoolDeleteFunc)deleteToken,
 		(objPoolClearFunc)clearToken,
 		NULL);
+	cxxTokenChainAPIInit();
 }
 
 void cxxTokenAPINewFile(void)
@@ -70,6 +71,7 @@ void cxxTokenAPINewFile(void)
 
 void cxxTokenAPIDone(void)
 {
+	cxxTokenChainAPIDone();
 	objPoolDelete (g_pTokenPool);
 }
 
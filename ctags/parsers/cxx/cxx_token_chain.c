@@ -14,9 +14,35 @@
 #include "vstring.h"
 #include "debug.h"
 #include "routines.h"
+#include "objpool.h"
 
 #include <string.h>
 
+#define CXX_TOKEN_CHAIN_POOL_MAXIMUM_SIZE 1024
+
+// Chains are created and destroyed for nearly every parenthesis, bracket
+// and template argument list, so they are recycled just like tokens are.
+static objPool * g_pChainPool = NULL;
+
+static CXXTokenChain * createChain(void *createArg CTAGS_ATTR_UNUSED)
+{
+	return xMalloc(1, CXXTokenChain);
+}
+
+void cxxTokenChainAPIInit(void)
+{
+	g_pChainPool = objPoolNew(CXX_TOKEN_CHAIN_POOL_MAXIMUM_SIZE,
+		(objPoolCreateFunc)createChain, (objPoolDeleteFunc)eFree,
+		(objPoolClearFunc)cxxTokenChainInit,
+		NULL);
+}
+
+void cxxTokenChainAPIDone(void)
+{
+	objPoolDelete (g_pChainPool);
+	g_pChainPool = NULL;
+}
+
 void cxxTokenChainInit(CXXTokenChain * tc)
 {
 	Assert(tc);
@@ -27,9 +53,7 @@ void cxxTokenChainInit(CXXTokenChain * tc)
 
 CXXTokenChain * cxxTokenChainCreate(void)
 {
-	CXXTokenChain * tc = xMalloc(1, CXXTokenChain);
-	cxxTokenChainInit(tc);
-	return tc;
+	return objPoolGet (g_pChainPool);
 }
 
 void cxxTokenChainDestroy(CXXTokenChain * tc)
@@ -48,7 +72,7 @@ void cxxTokenChainDestroy(CXXTokenChain * tc)
 		t = t2;
 	}
 
-	eFree(tc);
+	objPoolPut (g_pChainPool, tc);
 }
 
 CXXToken * cxxTokenChainTakeFirst(CXXTokenChain * tc)
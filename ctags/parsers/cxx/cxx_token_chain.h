@@ -24,6 +24,10 @@ struct _CXXTokenChain
 // The struct is typedef'd in cxx_token.h
 // typedef struct _CXXTokenChain CXXTokenChain;
 
+// Called by cxxTokenAPIInit() and cxxTokenAPIDone().
+void cxxTokenChainAPIInit(void);
+void cxxTokenChainAPIDone(void);
+
 CXXTokenChain * cxxTokenChainCreate(void);
 void cxxTokenChainDestroy(CXXTokenChain * tc);
 
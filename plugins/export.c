@@ -25,10 +25,20 @@
 #endif
 
 #include <ctype.h>
+#include <errno.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
 
 #include "geanyplugin.h"
 
+#ifdef G_OS_WIN32
+# include <io.h>
+# define fsync _commit
+#endif
+
 
 GeanyData		*geany_data;
 
@@ -40,6 +50,8 @@ PLUGIN_SET_INFO(_("Export"), _("Exports the current file into different formats.
 static GtkWidget *main_menu_item = NULL;
 
 
+/* size of the buffered output written to the file at once */
+#define EXPORT_CHUNK_SIZE (64 * 1024)
 #define ROTATE_RGB(color) \
 	(((color) & 0xFF0000) >> 16) + ((color) & 0x00FF00) + (((color) & 0x0000FF) << 16)
 #define TEMPLATE_HTML "\
@@ -269,9 +281,8 @@ static void on_menu_create_html_activate(GtkMenuItem *menuitem, gpointer user_da
 }
 
 
-static void write_data(const gchar *filename, const gchar *data)
+static void report_export_result(const gchar *filename, gint error_nr)
 {
-	gint error_nr = utils_write_file(filename, data);
 	gchar *utf8_filename = utils_get_utf8_from_locale(filename);
 
 	if (error_nr == 0)
@@ -284,6 +295,97 @@ static void write_data(const gchar *filename, const gchar *data)
 }
 
 
+/* With safe file saving, the output goes to a temporary file in the same directory
+ * (returned in tmp_filename) which replaces the target file once it is complete. */
+static FILE *open_export_file(const gchar *filename, gchar **tmp_filename)
+{
+	FILE *fp = NULL;
+	gint fd;
+
+	errno = 0;
+	*tmp_filename = NULL;
+	if (geany->file_prefs->use_safe_file_saving)
+	{
+		*tmp_filename = g_strconcat(filename, ".XXXXXX", NULL);
+		fd = g_mkstemp_full(*tmp_filename, O_WRONLY, 0666);
+		if (fd != -1)
+		{
+			fp = fdopen(fd, "w");
+			if (fp == NULL)
+			{
+				gint save_errno = errno;
+
+				g_close(fd, NULL);
+				g_unlink(*tmp_filename);
+				errno = save_errno;
+			}
+		}
+		if (fp == NULL)
+			SETPTR(*tmp_filename, NULL);
+	}
+	else
+		fp = g_fopen(filename, "w");
+
+	if (fp == NULL)
+		report_export_result(filename, errno != 0 ? errno : EIO);
+	return fp;
+}
+
+
+static void close_export_file(const gchar *filename, gchar *tmp_filename, FILE *fp)
+{
+	gint error_nr = ferror(fp) ? EIO : 0;
+
+	errno = 0;
+	/* the data must be on disk before the temporary file replaces the target file */
+	if (tmp_filename != NULL && error_nr == 0 && (fflush(fp) != 0 || fsync(fileno(fp)) != 0))
+		error_nr = errno != 0 ? errno : EIO;
+	errno = 0;
+	if (fclose(fp) != 0 && error_nr == 0)
+		error_nr = errno != 0 ? errno : EIO;
+
+	if (tmp_filename != NULL)
+	{
+		errno = 0;
+		if (error_nr == 0 && g_rename(tmp_filename, filename) != 0)
+			error_nr = errno != 0 ? errno : EIO;
+		if (error_nr != 0)
+			g_unlink(tmp_filename);
+		g_free(tmp_filename);
+	}
+	report_export_result(filename, error_nr);
+}
+
+
+/* writes and empties the buffered output */
+static void write_chunk(FILE *fp, GString *chunk)
+{
+	fwrite(chunk->str, 1, chunk->len, fp);
+	g_string_truncate(chunk, 0);
+}
+
+
+/* writes the part of the template before or after {export_content}, with the other
+ * placeholders filled in */
+static void write_template_part(FILE *fp, const gchar *template, gboolean before_content,
+	const gchar *styles, const gchar *date, const gchar *filename)
+{
+	const gchar *content = strstr(template, "{export_content}");
+	GString *part;
+
+	if (before_content)
+		part = g_string_new_len(template, content - template);
+	else
+		part = g_string_new(content + strlen("{export_content}"));
+
+	utils_string_replace_all(part, "{export_styles}", styles);
+	utils_string_replace_all(part, "{export_date}", date);
+	utils_string_replace_all(part, "{export_filename}", filename);
+	write_chunk(fp, part);
+	g_string_free(part, TRUE);
+}
+
+
 static gchar *get_date(gint type)
 {
 	const gchar *format;
@@ -359,20 +461,50 @@ static gint get_line_number_width(GeanyDocument *doc)
 }
 
 
+/* marks the styles write_latex_file() opens a block for, i.e. those of all characters
+ * but the second one of a double space */
+static void mark_used_latex_styles(ScintillaObject *sci, gint styles[][MAX_TYPES])
+{
+	SciStyleRunIter *iter = sci_style_run_iter_new(sci, 0, -1);
+	const gchar *text;
+	gint i, length, style;
+	gboolean skip_next = FALSE;
+
+	while (sci_style_run_iter_next(iter, &style, &text, &length))
+	{
+		for (i = 0; i < length; i++)
+		{
+			if (skip_next)
+				skip_next = FALSE;
+			else
+			{
+				styles[style][USED] = 1;
+				skip_next = (text[i] == ' ' && text[i + 1] == ' ');
+			}
+		}
+	}
+	sci_style_run_iter_free(iter);
+}
+
+
 static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 	gboolean use_zoom, gboolean insert_line_numbers)
 {
 	GeanyEditor *editor = doc->editor;
 	ScintillaObject *sci = doc->editor->sci;
-	gint i, doc_len, style = -1, old_style = 0, column = 0;
-	gint k, line_number, line_number_width, line_number_max_width = 0, pad;
+	SciStyleRunIter *iter;
+	const gchar *text;
+	gint i, length, style, old_style = 0, column = 0, tab_width;
+	gint k, line_number = 1, line_number_width, line_number_max_width = 0, pad;
 	gchar c, c_next, *tmp, *date;
 	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
 	gint styles[STYLE_MAX + 1][MAX_TYPES];
 	gboolean block_open = FALSE;
+	gboolean skip_next = FALSE;
 	GString *body;
 	GString *cmds;
-	GString *latex;
+	FILE *fp;
+	gchar *tmp_filename;
 
 	/* first read all styles from Scintilla */
 	for (i = 0; i < STYLE_MAX; i++)
@@ -384,132 +516,15 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 		styles[i][USED] = 0;
 	}
 
+	fp = open_export_file(filename, &tmp_filename);
+	if (fp == NULL)
+		return;
+
 	if (insert_line_numbers)
 		line_number_max_width = get_line_number_width(doc);
 
-	/* read the document and write the LaTeX code */
-	body = g_string_new("");
-	doc_len = sci_get_length(sci);
-	for (i = 0; i < doc_len; i++)
-	{
-		style = sci_get_style_at(sci, i);
-		c = sci_get_char_at(sci, i);
-		c_next = sci_get_char_at(sci, i + 1);
-
-		/* line numbers */
-		if (insert_line_numbers && column == 0)
-		{
-			line_number = sci_get_line_from_position(sci, i) + 1;
-			line_number_width = get_line_numbers_arity(line_number);
-			/* padding */
-			pad = line_number_max_width - line_number_width;
-			for (k = 0; k < pad; k++)
-			{
-				g_string_append(body, " ");
-			}
-			g_string_append_printf(body, "%d ", line_number);
-		}
-
-		if (style != old_style || ! block_open)
-		{
-			old_style = style;
-			styles[style][USED] = 1;
-			if (block_open)
-			{
-				g_string_append(body, "}\n");
-				block_open = FALSE;
-			}
-			if (i < doc_len)
-			{
-				g_string_append_printf(body, "\\style%s{", get_tex_style(style));
-				block_open = TRUE;
-			}
-		}
-		/* escape the current character if necessary else just add it */
-		switch (c)
-		{
-			case '\r':
-			case '\n':
-			{
-				if (c == '\r' && c_next == '\n')
-					continue; /* when using CR/LF skip CR and add the line break with LF */
-
-				if (block_open)
-				{
-					g_string_append(body, "}");
-					block_open = FALSE;
-				}
-				g_string_append(body, " \\\\\n");
-				column = -1;
-				break;
-			}
-			case '\t':
-			{
-				gint tab_width = sci_get_tab_width(editor->sci);
-				gint tab_stop = tab_width - (column % tab_width);
-
-				column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
-				g_string_append_printf(body, "\\hspace*{%dem}", tab_stop);
-				break;
-			}
-			case ' ':
-			{
-				if (c_next == ' ')
-				{
-					g_string_append(body, "{\\hspace*{1em}}");
-					i++; /* skip the next character */
-				}
-				else
-					g_string_append_c(body, ' ');
-				break;
-			}
-			case '{':
-			case '}':
-			case '_':
-			case '&':
-			case '$':
-			case '#':
-			case '%':
-			{
-				g_string_append_printf(body, "\\%c", c);
-				break;
-			}
-			case '\\':
-			{
-				g_string_append(body, "\\symbol{92}");
-				break;
-			}
-			case '~':
-			{
-				g_string_append(body, "\\symbol{126}");
-				break;
-			}
-			case '^':
-			{
-				g_string_append(body, "\\symbol{94}");
-				break;
-			}
-			/* mask "--", "<<" and ">>" */
-			case '-':
-			case '<':
-			case '>':
-			{
-				g_string_append_c(body, c);
-				if (c_next == c)
-					g_string_append(body, "\\/");
-
-				break;
-			}
-			default: g_string_append_c(body, c);
-		}
-		column++;
-	}
-	if (block_open)
-	{
-		g_string_append(body, "}\n");
-		block_open = FALSE;
-	}
-
+	/* the header lists the used styles, so find them before streaming the body */
+	mark_used_latex_styles(sci, styles);
 	/* force writing of style 0 (used at least for line breaks) */
 	styles[0][USED] = 1;
 
@@ -543,29 +558,177 @@ static void write_latex_file(GeanyDocument *doc, const gchar *filename,
 	}
 
 	date = get_date(DATE_TYPE_DEFAULT);
-	/* write all */
-	latex = g_string_new(TEMPLATE_LATEX);
-	utils_string_replace_all(latex, "{export_content}", body->str);
-	utils_string_replace_all(latex, "{export_styles}", cmds->str);
-	utils_string_replace_all(latex, "{export_date}", date);
-	utils_string_replace_all(latex, "{export_filename}", DOC_FILENAME(doc));
+	write_template_part(fp, TEMPLATE_LATEX, TRUE, cmds->str, date, DOC_FILENAME(doc));
+
+	/* read the document and write the LaTeX code */
+	body = g_string_sized_new(EXPORT_CHUNK_SIZE + 1024);
+	tab_width = sci_get_tab_width(editor->sci);
+	iter = sci_style_run_iter_new(sci, 0, -1);
+	while (sci_style_run_iter_next(iter, &style, &text, &length))
+	{
+		for (i = 0; i < length; i++)
+		{
+			if (skip_next)
+			{
+				skip_next = FALSE;
+				continue;
+			}
 
-	write_data(filename, latex->str);
+			c = text[i];
+			c_next = text[i + 1];
+
+			/* line numbers */
+			if (insert_line_numbers && column == 0)
+			{
+				line_number_width = get_line_numbers_arity(line_number);
+				/* padding */
+				pad = line_number_max_width - line_number_width;
+				for (k = 0; k < pad; k++)
+				{
+					g_string_append(body, " ");
+				}
+				g_string_append_printf(body, "%d ", line_number);
+			}
+
+			if (style != old_style || ! block_open)
+			{
+				old_style = style;
+				if (block_open)
+				{
+					g_string_append(body, "}\n");
+					block_open = FALSE;
+				}
+				g_string_append_printf(body, "\\style%s{", get_tex_style(style));
+				block_open = TRUE;
+			}
+			/* escape the current character if necessary else just add it */
+			switch (c)
+			{
+				case '\r':
+				case '\n':
+				{
+					if (c == '\r' && c_next == '\n')
+						continue; /* when using CR/LF skip CR and add the line break with LF */
+
+					if (block_open)
+					{
+						g_string_append(body, "}");
+						block_open = FALSE;
+					}
+					g_string_append(body, " \\\\\n");
+					column = -1;
+					line_number++;
+					break;
+				}
+				case '\t':
+				{
+					gint tab_stop = tab_width - (column % tab_width);
+
+					column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
+					g_string_append_printf(body, "\\hspace*{%dem}", tab_stop);
+					break;
+				}
+				case ' ':
+				{
+					if (c_next == ' ')
+					{
+						g_string_append(body, "{\\hspace*{1em}}");
+						skip_next = TRUE; /* skip the next character */
+					}
+					else
+						g_string_append_c(body, ' ');
+					break;
+				}
+				case '{':
+				case '}':
+				case '_':
+				case '&':
+				case '$':
+				case '#':
+				case '%':
+				{
+					g_string_append_printf(body, "\\%c", c);
+					break;
+				}
+				case '\\':
+				{
+					g_string_append(body, "\\symbol{92}");
+					break;
+				}
+				case '~':
+				{
+					g_string_append(body, "\\symbol{126}");
+					break;
+				}
+				case '^':
+				{
+					g_string_append(body, "\\symbol{94}");
+					break;
+				}
+				/* mask "--", "<<" and ">>" */
+				case '-':
+				case '<':
+				case '>':
+				{
+					g_string_append_c(body, c);
+					if (c_next == c)
+						g_string_append(body, "\\/");
+
+					break;
+				}
+				default: g_string_append_c(body, c);
+			}
+			column++;
+		}
+		if (body->len >= EXPORT_CHUNK_SIZE)
+			write_chunk(fp, body);
+	}
+	sci_style_run_iter_free(iter);
+	if (block_open)
+	{
+		g_string_append(body, "}\n");
+		block_open = FALSE;
+	}
+	write_chunk(fp, body);
+
+	write_template_part(fp, TEMPLATE_LATEX, FALSE, cmds->str, date, DOC_FILENAME(doc));
+	close_export_file(filename, tmp_filename, fp);
 
 	g_string_free(body, TRUE);
 	g_string_free(cmds, TRUE);
-	g_string_free(latex, TRUE);
 	g_free(date);
 }
 
 
+/* marks the styles write_html_file() opens a span for, i.e. those of all non-space
+ * characters */
+static void mark_used_html_styles(ScintillaObject *sci, gint styles[][MAX_TYPES])
+{
+	SciStyleRunIter *iter = sci_style_run_iter_new(sci, 0, -1);
+	const gchar *text;
+	gint i, length, style;
+
+	while (sci_style_run_iter_next(iter, &style, &text, &length))
+	{
+		for (i = 0; i < length && ! styles[style][USED]; i++)
+		{
+			if (! isspace(text[i]))
+				styles[style][USED] = 1;
+		}
+	}
+	sci_style_run_iter_free(iter);
+}
+
+
 static void write_html_file(GeanyDocument *doc, const gchar *filename,
 	gboolean use_zoom, gboolean insert_line_numbers)
 {
 	GeanyEditor *editor = doc->editor;
 	ScintillaObject *sci = doc->editor->sci;
-	gint i, doc_len, style = -1, old_style = 0, column = 0;
-	gint k, line_number, line_number_width, line_number_max_width = 0, pad;
+	SciStyleRunIter *iter;
+	const gchar *text;
+	gint i, length, style, old_style = 0, column = 0, tab_width;
+	gint k, line_number = 1, line_number_width, line_number_max_width = 0, pad;
 	gchar c, c_next, *date, *doc_filename;
 	/* 0 - fore, 1 - back, 2 - bold, 3 - italic, 4 - font size, 5 - used(0/1) */
 	gint styles[STYLE_MAX + 1][MAX_TYPES];
@@ -575,7 +738,8 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 	PangoFontDescription *font_desc;
 	GString *body;
 	GString *css;
-	GString *html;
+	FILE *fp;
+	gchar *tmp_filename;
 
 	/* first read all styles from Scintilla */
 	for (i = 0; i < STYLE_MAX; i++)
@@ -587,6 +751,10 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 		styles[i][USED] = 0;
 	}
 
+	fp = open_export_file(filename, &tmp_filename);
+	if (fp == NULL)
+		return;
+
 	/* read Geany's font and font size */
 	font_desc = pango_font_description_from_string(geany->interface_prefs->editor_font);
 	font_name = pango_font_description_get_family(font_desc);
@@ -599,138 +767,137 @@ static void write_html_file(GeanyDocument *doc, const gchar *filename,
 	if (insert_line_numbers)
 		line_number_max_width = get_line_number_width(doc);
 
-	/* read the document and write the HTML body */
-	body = g_string_new("");
-	doc_len = sci_get_length(sci);
-	for (i = 0; i < doc_len; i++)
-	{
-		style = sci_get_style_at(sci, i);
-		c = sci_get_char_at(sci, i);
-		/* sci_get_char_at() takes care of index boundaries and return 0 if i is too high */
-		c_next = sci_get_char_at(sci, i + 1);
+	/* the header lists the used styles, so find them before streaming the body */
+	mark_used_html_styles(sci, styles);
 
-		/* line numbers */
-		if (insert_line_numbers && column == 0)
+	/* write used styles in the header */
+	css = g_string_new("");
+	g_string_append_printf(css,
+	"\tbody\n\t{\n\t\tfont-family: %s, monospace;\n\t\tfont-size: %dpt;\n\t}\n",
+				font_name, font_size);
+
+	for (i = 0; i < STYLE_MAX; i++)
+	{
+		if (styles[i][USED])
 		{
-			line_number = sci_get_line_from_position(sci, i) + 1;
-			line_number_width = get_line_numbers_arity(line_number);
-			/* padding */
-			pad = line_number_max_width - line_number_width;
-			for (k = 0; k < pad; k++)
-			{
-				g_string_append(body, "&nbsp;");
-			}
-			g_string_append_printf(body, "%d&nbsp;", line_number);
+			g_string_append_printf(css,
+	"\t.style_%d\n\t{\n\t\tcolor: #%06x;\n\t\tbackground-color: #%06x;\n%s%s\t}\n",
+				i, styles[i][FORE], styles[i][BACK],
+				(styles[i][BOLD]) ? "\t\tfont-weight: bold;\n" : "",
+				(styles[i][ITALIC]) ? "\t\tfont-style: italic;\n" : "");
 		}
+	}
+
+	date = get_date(DATE_TYPE_HTML);
+	doc_filename = g_markup_escape_text(DOC_FILENAME(doc), -1);
+	write_template_part(fp, TEMPLATE_HTML, TRUE, css->str, date, doc_filename);
 
-		if ((style != old_style || ! span_open) && ! isspace(c))
+	/* read the document and write the HTML body */
+	body = g_string_sized_new(EXPORT_CHUNK_SIZE + 1024);
+	tab_width = sci_get_tab_width(editor->sci);
+	iter = sci_style_run_iter_new(sci, 0, -1);
+	while (sci_style_run_iter_next(iter, &style, &text, &length))
+	{
+		for (i = 0; i < length; i++)
 		{
-			old_style = style;
-			styles[style][USED] = 1;
-			if (span_open)
-			{
-				g_string_append(body, "</span>");
-			}
-			if (i < doc_len)
+			c = text[i];
+			c_next = text[i + 1];
+
+			/* line numbers */
+			if (insert_line_numbers && column == 0)
 			{
-				g_string_append_printf(body, "<span class=\"style_%d\">", style);
-				span_open = TRUE;
+				line_number_width = get_line_numbers_arity(line_number);
+				/* padding */
+				pad = line_number_max_width - line_number_width;
+				for (k = 0; k < pad; k++)
+				{
+					g_string_append(body, "&nbsp;");
+				}
+				g_string_append_printf(body, "%d&nbsp;", line_number);
 			}
-		}
-		/* escape the current character if necessary else just add it */
-		switch (c)
-		{
-			case '\r':
-			case '\n':
-			{
-				if (c == '\r' && c_next == '\n')
-					continue; /* when using CR/LF skip CR and add the line break with LF */
 
+			if ((style != old_style || ! span_open) && ! isspace(c))
+			{
+				old_style = style;
 				if (span_open)
 				{
 					g_string_append(body, "</span>");
-					span_open = FALSE;
 				}
-				g_string_append(body, "<br />\n");
-				column = -1;
-				break;
+				g_string_append_printf(body, "<span class=\"style_%d\">", style);
+				span_open = TRUE;
 			}
-			case '\t':
+			/* escape the current character if necessary else just add it */
+			switch (c)
 			{
-				gint j;
-				gint tab_width = sci_get_tab_width(editor->sci);
-				gint tab_stop = tab_width - (column % tab_width);
-
-				column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
-				for (j = 0; j < tab_stop; j++)
+				case '\r':
+				case '\n':
+				{
+					if (c == '\r' && c_next == '\n')
+						continue; /* when using CR/LF skip CR and add the line break with LF */
+
+					if (span_open)
+					{
+						g_string_append(body, "</span>");
+						span_open = FALSE;
+					}
+					g_string_append(body, "<br />\n");
+					column = -1;
+					line_number++;
+					break;
+				}
+				case '\t':
+				{
+					gint j;
+					gint tab_stop = tab_width - (column % tab_width);
+
+					column += tab_stop - 1; /* -1 because we add 1 at the end of the loop */
+					for (j = 0; j < tab_stop; j++)
+					{
+						g_string_append(body, "&nbsp;");
+					}
+					break;
+				}
+				case ' ':
 				{
 					g_string_append(body, "&nbsp;");
+					break;
 				}
-				break;
-			}
-			case ' ':
-			{
-				g_string_append(body, "&nbsp;");
-				break;
-			}
-			case '<':
-			{
-				g_string_append(body, "&lt;");
-				break;
-			}
-			case '>':
-			{
-				g_string_append(body, "&gt;");
-				break;
-			}
-			case '&':
-			{
-				g_string_append(body, "&amp;");
-				break;
+				case '<':
+				{
+					g_string_append(body, "&lt;");
+					break;
+				}
+				case '>':
+				{
+					g_string_append(body, "&gt;");
+					break;
+				}
+				case '&':
+				{
+					g_string_append(body, "&amp;");
+					break;
+				}
+				default: g_string_append_c(body, c);
 			}
-			default: g_string_append_c(body, c);
+			column++;
 		}
-		column++;
+		if (body->len >= EXPORT_CHUNK_SIZE)
+			write_chunk(fp, body);
 	}
+	sci_style_run_iter_free(iter);
 	if (span_open)
 	{
 		g_string_append(body, "</span>");
 		span_open = FALSE;
 	}
+	write_chunk(fp, body);
 
-	/* write used styles in the header */
-	css = g_string_new("");
-	g_string_append_printf(css,
-	"\tbody\n\t{\n\t\tfont-family: %s, monospace;\n\t\tfont-size: %dpt;\n\t}\n",
-				font_name, font_size);
-
-	for (i = 0; i < STYLE_MAX; i++)
-	{
-		if (styles[i][USED])
-		{
-			g_string_append_printf(css,
-	"\t.style_%d\n\t{\n\t\tcolor: #%06x;\n\t\tbackground-color: #%06x;\n%s%s\t}\n",
-				i, styles[i][FORE], styles[i][BACK],
-				(styles[i][BOLD]) ? "\t\tfont-weight: bold;\n" : "",
-				(styles[i][ITALIC]) ? "\t\tfont-style: italic;\n" : "");
-		}
-	}
-
-	date = get_date(DATE_TYPE_HTML);
-	doc_filename = g_markup_escape_text(DOC_FILENAME(doc), -1);
-	/* write all */
-	html = g_string_new(TEMPLATE_HTML);
-	utils_string_replace_all(html, "{export_date}", date);
-	utils_string_replace_all(html, "{export_content}", body->str);
-	utils_string_replace_all(html, "{export_styles}", css->str);
-	utils_string_replace_all(html, "{export_filename}", doc_filename);
-
-	write_data(filename, html->str);
+	write_template_part(fp, TEMPLATE_HTML, FALSE, css->str, date, doc_filename);
+	close_export_file(filename, tmp_filename, fp);
 
 	pango_font_description_free(font_desc);
 	g_string_free(body, TRUE);
 	g_string_free(css, TRUE);
-	g_string_free(html, TRUE);
 	g_free(doc_filename);
 	g_free(date);
 }
@@ -68,6 +68,21 @@ enum
 	FILEVIEW_N_COLUMNS
 };
 
+/* number of entries read from a directory at once */
+#define DIR_LISTING_BATCH_SIZE 256
+
+typedef struct
+{
+	gchar *name;	/* in locale-encoding */
+	gboolean dir;
+} DirEntry;
+
+typedef struct
+{
+	GPtrArray *entries;
+	GCancellable *cancellable;
+} DirListing;
+
 static gboolean fb_set_project_base_path = FALSE;
 static gboolean fb_follow_path = FALSE;
 static gboolean show_hidden_files = FALSE;
@@ -76,7 +91,6 @@ static gboolean hide_object_files = TRUE;
 static GtkWidget *file_view_vbox;
 static GtkWidget *file_view;
 static GtkListStore *file_store;
-static GtkTreeIter *last_dir_iter = NULL;
 static GtkEntryCompletion *entry_completion = NULL;
 
 static GtkWidget *filter_combo;
@@ -88,6 +102,9 @@ static gchar *open_cmd; /* in locale-encoding */
 static gchar *config_file;
 static gchar **filter = NULL;
 static gchar *hidden_file_extensions = NULL;
+static GPtrArray *dir_entries = NULL; /* entries of current_dir, NULL while listing */
+static GCancellable *listing_cancellable = NULL; /* of the running listing */
+static GHashTable *icon_cache = NULL; /* content type -> GIcon */
 
 static gint page_number = 0;
 
@@ -142,22 +159,16 @@ static gboolean check_hidden(const gchar *filename, const gchar *base_name)
 }
 
 
-static gboolean check_object(const gchar *base_name)
+static gboolean check_object(const gchar *base_name, gchar **exts)
 {
-	gboolean ret = FALSE;
 	gchar **ptr;
-	gchar **exts = g_strsplit(hidden_file_extensions, " ", -1);
 
 	foreach_strv(ptr, exts)
 	{
 		if (g_str_has_suffix(base_name, *ptr))
-		{
-			ret = TRUE;
-			break;
-		}
+			return TRUE;
 	}
-	g_strfreev(exts);
-	return ret;
+	return FALSE;
 }
 
 
@@ -189,6 +200,14 @@ static GIcon *get_icon(const gchar *fname)
 
 	if (ctype)
 	{
+		/* the icon theme lookup is by far the slowest part, so do it once per type */
+		icon = g_hash_table_lookup(icon_cache, ctype);
+		if (icon)
+		{
+			g_free(ctype);
+			return g_object_ref(icon);
+		}
+
 		icon = g_content_type_get_icon(ctype);
 		if (icon)
 		{
@@ -203,66 +222,48 @@ static GIcon *get_icon(const gchar *fname)
 			else
 				gtk_icon_info_free(icon_info);
 		}
-		g_free(ctype);
 	}
 
 	if (!icon)
 		icon = g_themed_icon_new("text-x-generic");
 
+	if (ctype)
+		g_hash_table_insert(icon_cache, ctype, g_object_ref(icon));
+
 	return icon;
 }
 
 
-/* name is in locale encoding */
-static void add_item(const gchar *name)
+static void add_item(const DirEntry *entry, gchar **object_exts)
 {
-	GtkTreeIter iter;
 	gchar *fname, *utf8_name, *utf8_fullname;
 	const gchar *sep;
-	gboolean dir;
 	GIcon *icon;
 
-	if (G_UNLIKELY(EMPTY(name)))
-		return;
-
 	/* root directory doesn't need separator */
 	sep = (utils_str_equal(current_dir, "/")) ? "" : G_DIR_SEPARATOR_S;
-	fname = g_strconcat(current_dir, sep, name, NULL);
-	dir = g_file_test(fname, G_FILE_TEST_IS_DIR);
+	fname = g_strconcat(current_dir, sep, entry->name, NULL);
 	utf8_fullname = utils_get_utf8_from_locale(fname);
-	utf8_name = utils_get_utf8_from_locale(name);
+	utf8_name = utils_get_utf8_from_locale(entry->name);
 	g_free(fname);
 
 	if (! show_hidden_files && check_hidden(utf8_fullname, utf8_name))
 		goto done;
 
-	if (dir)
+	if (! entry->dir)
 	{
-		if (last_dir_iter == NULL)
-			gtk_list_store_prepend(file_store, &iter);
-		else
-		{
-			gtk_list_store_insert_after(file_store, &iter, last_dir_iter);
-			gtk_tree_iter_free(last_dir_iter);
-		}
-		last_dir_iter = gtk_tree_iter_copy(&iter);
-	}
-	else
-	{
-		if (! show_hidden_files && hide_object_files && check_object(utf8_name))
+		if (! show_hidden_files && hide_object_files && check_object(utf8_name, object_exts))
 			goto done;
 		if (check_filtered(utf8_name))
 			goto done;
-
-		gtk_list_store_append(file_store, &iter);
 	}
 
-	icon = dir ? g_themed_icon_new("folder") : get_icon(utf8_name);
-	gtk_list_store_set(file_store, &iter,
+	icon = entry->dir ? g_themed_icon_new("folder") : get_icon(utf8_name);
+	gtk_list_store_insert_with_values(file_store, NULL, -1,
 		FILEVIEW_COLUMN_ICON, icon,
 		FILEVIEW_COLUMN_NAME, utf8_name,
 		FILEVIEW_COLUMN_FILENAME, utf8_fullname,
-		FILEVIEW_COLUMN_IS_DIR, dir,
+		FILEVIEW_COLUMN_IS_DIR, entry->dir,
 		-1);
 	g_object_unref(icon);
 done:
@@ -274,7 +275,6 @@ done:
 /* adds ".." to the start of the file list */
 static void add_top_level_entry(void)
 {
-	GtkTreeIter iter;
 	gchar *utf8_dir;
 	GIcon *icon;
 
@@ -284,11 +284,8 @@ static void add_top_level_entry(void)
 	utf8_dir = g_path_get_dirname(current_dir);
 	SETPTR(utf8_dir, utils_get_utf8_from_locale(utf8_dir));
 
-	gtk_list_store_prepend(file_store, &iter);
-	last_dir_iter = gtk_tree_iter_copy(&iter);
-
 	icon = g_themed_icon_new("folder");
-	gtk_list_store_set(file_store, &iter,
+	gtk_list_store_insert_with_values(file_store, NULL, 0,
 		FILEVIEW_COLUMN_ICON, icon,
 		FILEVIEW_COLUMN_NAME, "..",
 		FILEVIEW_COLUMN_FILENAME, utf8_dir,
@@ -302,11 +299,138 @@ static void add_top_level_entry(void)
 static void clear(void)
 {
 	gtk_list_store_clear(file_store);
+}
+
+
+static void dir_entry_free(DirEntry *entry)
+{
+	g_free(entry->name);
+	g_slice_free(DirEntry, entry);
+}
+
+
+/* directories first, then by name */
+static gint dir_entry_compare(gconstpointer a, gconstpointer b)
+{
+	const DirEntry *entry_a = *(const DirEntry **) a;
+	const DirEntry *entry_b = *(const DirEntry **) b;
+
+	if (entry_a->dir != entry_b->dir)
+		return entry_a->dir ? -1 : 1;
+	return utils_str_casecmp(entry_a->name, entry_b->name);
+}
+
 
-	/* reset the directory item pointer */
-	if (last_dir_iter != NULL)
-		gtk_tree_iter_free(last_dir_iter);
-	last_dir_iter = NULL;
+/* fills the tree model from the entries of current_dir, applying the filters */
+static void fill_store(void)
+{
+	gchar **object_exts;
+	guint i;
+
+	/* detach the model, so the views are not updated for each row */
+	g_object_ref(file_store);
+	gtk_entry_completion_set_model(entry_completion, NULL);
+	gtk_tree_view_set_model(GTK_TREE_VIEW(file_view), NULL);
+
+	clear();
+	add_top_level_entry();	/* ".." item */
+
+	object_exts = g_strsplit(hidden_file_extensions, " ", -1);
+	for (i = 0; dir_entries != NULL && i < dir_entries->len; i++)
+		add_item(g_ptr_array_index(dir_entries, i), object_exts);
+	g_strfreev(object_exts);
+
+	gtk_tree_view_set_model(GTK_TREE_VIEW(file_view), GTK_TREE_MODEL(file_store));
+	gtk_entry_completion_set_model(entry_completion, GTK_TREE_MODEL(file_store));
+	g_object_unref(file_store);
+}
+
+
+static void dir_listing_free(DirListing *listing)
+{
+	if (listing->entries != NULL)
+		g_ptr_array_free(listing->entries, TRUE);
+	g_object_unref(listing->cancellable);
+	g_slice_free(DirListing, listing);
+}
+
+
+static void dir_listing_finish(DirListing *listing)
+{
+	if (! g_cancellable_is_cancelled(listing->cancellable))
+	{
+		g_ptr_array_sort(listing->entries, dir_entry_compare);
+		dir_entries = listing->entries;
+		listing->entries = NULL;
+		g_clear_object(&listing_cancellable);
+
+		fill_store();
+	}
+	dir_listing_free(listing);
+}
+
+
+static void on_dir_listing_next_files(GObject *source, GAsyncResult *result, gpointer data)
+{
+	GFileEnumerator *enumerator = G_FILE_ENUMERATOR(source);
+	DirListing *listing = data;
+	GList *files, *node;
+
+	files = g_file_enumerator_next_files_finish(enumerator, result, NULL);
+	foreach_list(node, files)
+	{
+		GFileInfo *info = node->data;
+		DirEntry *entry = g_slice_new(DirEntry);
+
+		entry->name = g_strdup(g_file_info_get_name(info));
+		entry->dir = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+		g_ptr_array_add(listing->entries, entry);
+		g_object_unref(info);
+	}
+
+	if (files != NULL && ! g_cancellable_is_cancelled(listing->cancellable))
+	{
+		g_file_enumerator_next_files_async(enumerator, DIR_LISTING_BATCH_SIZE,
+			G_PRIORITY_LOW, listing->cancellable, on_dir_listing_next_files, listing);
+	}
+	else
+	{
+		g_object_unref(enumerator);
+		dir_listing_finish(listing);
+	}
+	g_list_free(files);
+}
+
+
+static void on_dir_listing_enumerated(GObject *source, GAsyncResult *result, gpointer data)
+{
+	DirListing *listing = data;
+	GFileEnumerator *enumerator;
+
+	enumerator = g_file_enumerate_children_finish(G_FILE(source), result, NULL);
+	if (enumerator == NULL)
+	{
+		/* unreadable directory, only show ".." like before */
+		dir_listing_finish(listing);
+		return;
+	}
+	g_file_enumerator_next_files_async(enumerator, DIR_LISTING_BATCH_SIZE,
+		G_PRIORITY_LOW, listing->cancellable, on_dir_listing_next_files, listing);
+}
+
+
+static void cancel_dir_listing(void)
+{
+	if (listing_cancellable != NULL)
+	{
+		g_cancellable_cancel(listing_cancellable);
+		g_clear_object(&listing_cancellable);
+	}
+	if (dir_entries != NULL)
+	{
+		g_ptr_array_free(dir_entries, TRUE);
+		dir_entries = NULL;
+	}
 }
 
 
@@ -314,7 +438,11 @@ static void clear(void)
 static void refresh(void)
 {
 	gchar *utf8_dir;
-	GSList *list, *node;
+	DirListing *listing;
+	GFile *dir;
+
+	/* the entries would not belong to current_dir anymore */
+	cancel_dir_listing();
 
 	/* don't clear when the new path doesn't exist */
 	if (! g_file_test(current_dir, G_FILE_TEST_EXISTS))
@@ -330,20 +458,30 @@ static void refresh(void)
 
 	add_top_level_entry();	/* ".." item */
 
-	list = utils_get_file_list(current_dir, NULL, NULL);
-	if (list != NULL)
-	{
-		/* free filenames as we go through the list */
-		foreach_slist(node, list)
-		{
-			gchar *fname = node->data;
+	/* list the directory in the background, big ones would block the UI for too long;
+	 * only asking for the name and type lets GIO use readdir()'s d_type instead of stat() */
+	listing = g_slice_new(DirListing);
+	listing->entries = g_ptr_array_new_with_free_func((GDestroyNotify) dir_entry_free);
+	listing->cancellable = g_cancellable_new();
+	listing_cancellable = g_object_ref(listing->cancellable);
+
+	dir = g_file_new_for_path(current_dir);
+	g_file_enumerate_children_async(dir,
+		G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
+		G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, listing->cancellable,
+		on_dir_listing_enumerated, listing);
+	g_object_unref(dir);
+}
 
-			add_item(fname);
-			g_free(fname);
-		}
-		g_slist_free(list);
-	}
-	gtk_entry_completion_set_model(entry_completion, GTK_TREE_MODEL(file_store));
+
+/* re-applies the filters without listing the directory again */
+static void refilter(void)
+{
+	if (dir_entries != NULL)
+		fill_store();
+	else if (listing_cancellable == NULL)
+		refresh();
+	/* otherwise the running listing applies the filters when done */
 }
 
 
@@ -632,7 +770,7 @@ static void on_find_in_files(GtkMenuItem *menuitem, gpointer user_data)
 static void on_hidden_files_clicked(GtkCheckMenuItem *item)
 {
 	show_hidden_files = gtk_check_menu_item_get_active(item);
-	refresh();
+	refilter();
 }
 
 
@@ -853,7 +991,7 @@ static void on_filter_activate(GtkEntry *entry, gpointer user_data)
 		clear_filter();
 	}
 	ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(filter_combo), NULL, 0);
-	refresh();
+	refilter();
 }
 
 
@@ -861,7 +999,7 @@ static void on_filter_clear(GtkEntry *entry, gint icon_pos,
 							GdkEvent *event, gpointer data)
 {
 	clear_filter();
-	refresh();
+	refilter();
 }
 
 
@@ -1132,6 +1270,9 @@ void plugin_init(GeanyData *data)
 	GtkWidget *scrollwin, *toolbar, *filterbar;
 
 	filter = NULL;
+	icon_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+	/* a pending directory listing could call back after unloading */
+	plugin_module_make_resident(geany_plugin);
 
 	file_view_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
 	toolbar = make_toolbar();
@@ -1336,6 +1477,8 @@ void plugin_cleanup(void)
 	g_free(open_cmd);
 	g_free(hidden_file_extensions);
 	clear_filter();
+	cancel_dir_listing();
+	g_hash_table_destroy(icon_cache);
 	gtk_widget_destroy(file_view_vbox);
 	g_object_unref(G_OBJECT(entry_completion));
 }
@@ -49,6 +49,7 @@
 #include "plugindata.h"
 #include "pluginutils.h"
 #include "prefs.h"
+#include "profiling.h"
 #include "project.h"
 #include "sciwrappers.h"
 #include "search.h"
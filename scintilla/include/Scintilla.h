@@ -500,6 +500,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_CANPASTE 2173
 #define SCI_CANUNDO 2174
 #define SCI_EMPTYUNDOBUFFER 2175
+#define SCI_GETUNDOMEMORY 2990
+#define SCI_TRIMUNDOHISTORY 2991
 #define SCI_UNDO 2176
 #define SCI_CUT 2177
 #define SCI_COPY 2178
@@ -284,6 +284,8 @@ enum class Message {
 	CanPaste = 2173,
 	CanUndo = 2174,
 	EmptyUndoBuffer = 2175,
+	GetUndoMemory = 2990,
+	TrimUndoHistory = 2991,
 	Undo = 2176,
 	Cut = 2177,
 	Copy = 2178,
@@ -504,6 +504,53 @@ void UndoHistory::DeleteUndoHistory() {
 	tentativePoint = -1;
 }
 
+Sci::Position UndoHistory::Memory() const noexcept {
+	Sci::Position memory = 0;
+	for (int i = 1; i <= maxAction; i++)
+		memory += actions[i].lenData;
+	return memory;
+}
+
+int UndoHistory::Trim(Sci::Position maxBytes) {
+	// Steps which are still being built or can be undone as a group can't be split
+	if (undoSequenceDepth > 0 || TentativeActive())
+		return 0;
+	Sci::Position memory = Memory();
+	if (memory <= maxBytes)
+		return 0;
+
+	// Find the oldest step boundary from where the rest fits, never beyond the current action
+	int cut = 0;
+	for (int act = 1; act <= currentAction; act++) {
+		if (actions[act].at == ActionType::start) {
+			cut = act;
+			if (memory <= maxBytes)
+				break;
+		}
+		memory -= actions[act].lenData;
+	}
+	if (cut == 0)
+		return 0;
+
+	int steps = 0;
+	for (int act = 1; act < cut; act++) {
+		if (actions[act].at != ActionType::start && actions[act - 1].at == ActionType::start)
+			steps++;
+	}
+
+	// The start action at cut becomes the first one
+	std::vector<Action> kept;
+	kept.reserve(actions.size() - cut);
+	for (size_t i = cut; i < actions.size(); i++)
+		kept.push_back(std::move(actions[i]));
+	actions.swap(kept);
+	maxAction -= cut;
+	currentAction -= cut;
+	// A dropped save point can't be reached any more
+	savePoint = (savePoint >= cut) ? savePoint - cut : -1;
+	return steps;
+}
+
 void UndoHistory::SetSavePoint() noexcept {
 	savePoint = currentAction;
 }
@@ -1294,6 +1341,14 @@ void CellBuffer::DeleteUndoHistory() {
 	uh.DeleteUndoHistory();
 }
 
+Sci::Position CellBuffer::UndoMemory() const noexcept {
+	return uh.Memory();
+}
+
+int CellBuffer::TrimUndoHistory(Sci::Position maxBytes) {
+	return uh.Trim(maxBytes);
+}
+
 bool CellBuffer::CanUndo() const noexcept {
 	return uh.CanUndo();
 }
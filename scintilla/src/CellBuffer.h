@@ -78,6 +78,8 @@ public:
 	void EndUndoAction();
 	void DropUndoSequence();
 	void DeleteUndoHistory();
+	Sci::Position Memory() const noexcept;
+	int Trim(Sci::Position maxBytes);
 
 	/// The save point is a marker in the undo stack where the container has stated that
 	/// the buffer was saved. Undo and redo can move over the save point.
@@ -226,6 +228,8 @@ public:
 	void EndUndoAction();
 	void AddUndoAction(Sci::Position token, bool mayCoalesce);
 	void DeleteUndoHistory();
+	Sci::Position UndoMemory() const noexcept;
+	int TrimUndoHistory(Sci::Position maxBytes);
 
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
@@ -368,6 +368,8 @@ public:
 	bool CanUndo() const noexcept { return cb.CanUndo(); }
 	bool CanRedo() const noexcept { return cb.CanRedo(); }
 	void DeleteUndoHistory() { cb.DeleteUndoHistory(); }
+	Sci::Position UndoMemory() const noexcept { return cb.UndoMemory(); }
+	int TrimUndoHistory(Sci::Position maxBytes) { return cb.TrimUndoHistory(maxBytes); }
 	bool SetUndoCollection(bool collectUndo) {
 		return cb.SetUndoCollection(collectUndo);
 	}
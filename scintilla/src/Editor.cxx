@@ -5978,6 +5978,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->DeleteUndoHistory();
 		return 0;
 
+	case Message::GetUndoMemory:
+		return pdoc->UndoMemory();
+
+	case Message::TrimUndoHistory:
+		return pdoc->TrimUndoHistory(PositionFromUPtr(wParam));
+
 	case Message::GetFirstVisibleLine:
 		return topLine;
 
@@ -813,9 +813,9 @@ static void build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	build_info.file_type_id = (doc == NULL) ? GEANY_FILETYPES_NONE : doc->file_type->id;
 	build_info.message_count = 0;
 
-	if (!spawn_with_callbacks(working_dir, cmd, argv, NULL, 0, NULL, NULL, build_iofunc,
-		GINT_TO_POINTER(0), 0, build_iofunc, GINT_TO_POINTER(1), 0, build_exit_cb, NULL,
-		&build_info.pid, &error))
+	if (!spawn_with_callbacks(working_dir, cmd, argv, NULL, SPAWN_LINES_BATCHED, NULL, NULL,
+		build_iofunc, GINT_TO_POINTER(0), 0, build_iofunc, GINT_TO_POINTER(1), 0, build_exit_cb,
+		NULL, &build_info.pid, &error))
 	{
 		geany_debug("build command spawning failed: %s", error->message);
 		ui_set_statusbar(TRUE, _("Process failed (%s)"), error->message);
@@ -1042,8 +1042,17 @@ static void build_iofunc(GString *string, GIOCondition condition, gpointer data)
 {
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
-		process_build_output_line(string->str,
-			(GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK);
+		gchar *line = string->str;
+
+		/* the lines are batched, each one followed by a nul */
+		while (line < string->str + string->len)
+		{
+			gchar *next = line + strlen(line) + 1;
+
+			process_build_output_line(line,
+				(GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK);
+			line = next;
+		}
 	}
 }
 
@@ -44,6 +44,7 @@
 #include "main.h"
 #include "msgwindow.h"
 #include "navqueue.h"
+#include "perfdialog.h"
 #include "plugins.h"
 #include "pluginutils.h"
 #include "prefs.h"
@@ -363,11 +364,16 @@ void on_reload_all(GtkAction *action, gpointer user_data)
 		}
 	}
 
+	/* merge the tags of all the reloaded files into the workspace at once */
+	tm_workspace_begin_batch_update();
 	foreach_document(i)
 	{
 		if (! (documents[i]->file_name == NULL))
 			document_reload_force(documents[i], documents[i]->encoding);
 	}
+	tm_workspace_end_batch_update();
+	foreach_document(i)
+		document_highlight_tags(documents[i]);
 
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(main_widgets.notebook), cur_page);
 }
@@ -522,40 +528,14 @@ static void on_notebook1_switch_page_after(GtkNotebook *notebook, gpointer page,
 {
 	GeanyDocument *doc;
 
-	if (G_UNLIKELY(main_status.opening_session_files || main_status.closing_all))
+	if (G_UNLIKELY(main_status.opening_session_files || main_status.closing_all ||
+		main_status.opening_batch))
 		return;
 
 	doc = document_get_from_notebook_child(page);
 
 	if (doc != NULL)
-	{
-		GtkEntry *filter_entry = GTK_ENTRY(ui_lookup_widget(main_widgets.window, "entry_tagfilter"));
-		const gchar *entry_text = gtk_entry_get_text(filter_entry);
-
-		sidebar_select_openfiles_item(doc);
-		ui_save_buttons_toggle(doc->changed);
-		ui_set_window_title(doc);
-		ui_update_statusbar(doc, -1);
-		ui_update_popup_reundo_items(doc);
-		ui_document_show_hide(doc); /* update the document menu */
-		build_menu_update(doc);
-		if (g_strcmp0(entry_text, doc->priv->tag_filter) != 0)
-		{
-			/* calls sidebar_update_tag_list() in on_entry_tagfilter_changed() */
-			gtk_entry_set_text(filter_entry, doc->priv->tag_filter);
-		}
-		else
-			sidebar_update_tag_list(doc, TRUE);
-		document_highlight_tags(doc);
-
-		document_check_disk_status(doc, TRUE);
-
-#ifdef HAVE_VTE
-		vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
-#endif
-
-		g_signal_emit_by_name(geany_object, "document-activate", doc);
-	}
+		document_update_after_switch(doc);
 }
 
 
@@ -799,7 +779,7 @@ static void on_set_file_readonly1_toggled(GtkCheckMenuItem *checkmenuitem, gpoin
 		g_return_if_fail(doc != NULL);
 
 		doc->readonly = ! doc->readonly;
-		sci_set_readonly(doc->editor->sci, doc->readonly);
+		sci_set_readonly(doc->editor->sci, doc->readonly || doc->priv->protected > 0);
 		ui_update_tab_status(doc);
 		ui_update_statusbar(doc, -1);
 	}
@@ -1782,6 +1762,12 @@ static void on_debug_messages1_activate(GtkMenuItem *menuitem, gpointer user_dat
 }
 
 
+static void on_performance1_activate(GtkMenuItem *menuitem, gpointer user_data)
+{
+	perfdialog_show();
+}
+
+
 void on_send_selection_to_vte1_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
 #ifdef HAVE_VTE
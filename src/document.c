@@ -44,9 +44,11 @@
 #include "msgwindow.h"
 #include "navqueue.h"
 #include "notebook.h"
+#include "profiling.h"
 #include "project.h"
 #include "sciwrappers.h"
 #include "sidebar.h"
+#include "socket.h"
 #include "support.h"
 #include "symbols.h"
 #include "ui_utils.h"
@@ -62,6 +64,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 
 #ifdef HAVE_SYS_TYPES_H
 # include <sys/types.h>
@@ -94,6 +97,7 @@ typedef struct
 	guint type;			/* to identify the action */
 	gpointer *data; 	/* the old value (before the change), in case of a redo action
 						 * it contains the new value */
+	guint count;		/* number of consecutive UNDO_SCINTILLA actions this entry stands for */
 } undo_action;
 
 /* Custom document info bar response IDs */
@@ -106,8 +110,26 @@ enum
 
 static guint doc_id_counter = 0;
 
+/* see document_set_defer_loading() */
+static gboolean defer_loading = FALSE;
+static guint deferred_load_source = 0;
 
-static void document_undo_clear_stack(GTrashStack **stack);
+/* see document_begin_batch_open() */
+static guint batch_open_depth = 0;
+static GPtrArray *batch_deferred_docs = NULL;
+static GHashTable *prefetched_files = NULL;	/* locale filename -> PrefetchedFile */
+
+/* see prefetch_files() */
+static GMutex prefetch_mutex;
+static GCond prefetch_cond;
+static GThreadPool *prefetch_pool = NULL;
+static GPtrArray *prefetch_queue = NULL;	/* PrefetchedFile in the order of opening */
+static guint prefetch_queue_pos = 0;	/* the next file to be read */
+static guint prefetch_pending = 0;	/* files given to prefetch_pool and not opened yet */
+static guint prefetch_ahead = 0;
+
+
+static void document_undo_clear_stack(UndoStack *stack);
 static void document_undo_clear(GeanyDocument *doc);
 static void document_undo_add_internal(GeanyDocument *doc, guint type, gpointer data);
 static void document_redo_add(GeanyDocument *doc, guint type, gpointer data);
@@ -389,6 +411,9 @@ void document_finalize(void)
 {
 	guint i;
 
+	if (deferred_load_source != 0)
+		g_source_remove(deferred_load_source);
+
 	for (i = 0; i < documents_array->len; i++)
 		g_free(documents[i]);
 	g_ptr_array_free(documents_array, TRUE);
@@ -662,15 +687,17 @@ static GeanyDocument *document_create(const gchar *utf8_filename)
 
 	notebook_new_tab(doc);
 
-	/* select document in sidebar */
+	/* the current document is selected and the buttons updated once the batch is done */
+	if (! main_status.opening_batch)
 	{
 		GtkTreeSelection *sel;
 
+		/* select document in sidebar */
 		sel = gtk_tree_view_get_selection(GTK_TREE_VIEW(tv.tree_openfiles));
 		gtk_tree_selection_select_iter(sel, &doc->priv->iter);
-	}
 
-	ui_document_buttons_update();
+		ui_document_buttons_update();
+	}
 
 	doc->is_valid = TRUE;	/* do this last to prevent UI updating with NULL items. */
 	return doc;
@@ -703,6 +730,12 @@ static gboolean remove_page(guint page_num)
 
 	g_return_val_if_fail(doc != NULL, FALSE);
 
+	if (doc->priv->saving)
+	{
+		ui_set_statusbar(TRUE, _("The file \"%s\" is still being saved."), DOC_FILENAME(doc));
+		return FALSE;
+	}
+
 	/* if we're closing all, document_account_for_unsaved() has been called already, no need to ask again. */
 	if (! main_status.closing_all && doc->changed && ! dialogs_show_unsaved_file(doc))
 		return FALSE;
@@ -716,6 +749,11 @@ static gboolean remove_page(guint page_num)
 
 	g_datalist_clear(&doc->priv->data);
 
+	if (doc->priv->colourise_source != 0)
+		g_source_remove(doc->priv->colourise_source);
+	if (doc->priv->undo_trim_source != 0)
+		g_source_remove(doc->priv->undo_trim_source);
+
 	doc->is_valid = FALSE;
 	doc->id = 0;
 
@@ -754,6 +792,7 @@ static gboolean remove_page(guint page_num)
 
 	document_undo_clear(doc);
 
+	g_free(doc->priv->perf_stats);
 	g_free(doc->priv);
 
 	/* reset document settings to defaults for re-use */
@@ -925,15 +964,18 @@ typedef struct
 } FileData;
 
 
-static gboolean get_mtime(const gchar *locale_filename, time_t *time)
+/* Gets the modification time of locale_filename. This doesn't touch the UI, so it can be
+ * used from worker threads. */
+static gboolean query_mtime(const gchar *locale_filename, time_t *time, GError **error)
 {
-	GError *error = NULL;
+	GError *gio_error = NULL;
 	const gchar *err_msg = NULL;
+	gint code = G_FILE_ERROR_FAILED;
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
 		GFile *file = g_file_new_for_path(locale_filename);
-		GFileInfo *info = g_file_query_info(file, G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, NULL, &error);
+		GFileInfo *info = g_file_query_info(file, G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, NULL, &gio_error);
 
 		if (info)
 		{
@@ -943,8 +985,8 @@ static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 			g_object_unref(info);
 			*time = timeval.tv_sec;
 		}
-		else if (error)
-			err_msg = error->message;
+		else if (gio_error)
+			err_msg = gio_error->message;
 
 		g_object_unref(file);
 	}
@@ -955,30 +997,50 @@ static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 		if (g_stat(locale_filename, &st) == 0)
 			*time = st.st_mtime;
 		else
+		{
+			code = g_file_error_from_errno(errno);
 			err_msg = g_strerror(errno);
+		}
 	}
 
 	if (err_msg)
 	{
 		gchar *utf8_filename = utils_get_utf8_from_locale(locale_filename);
 
-		ui_set_statusbar(TRUE, _("Could not open file %s (%s)"),
+		g_set_error(error, G_FILE_ERROR, code, _("Could not open file %s (%s)"),
 			utf8_filename, err_msg);
 		g_free(utf8_filename);
 	}
 
-	if (error)
-		g_error_free(error);
+	if (gio_error)
+		g_error_free(gio_error);
 
 	return err_msg == NULL;
 }
 
 
-/* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM. */
-static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
-	FileData *filedata, const gchar *forced_enc)
+static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 {
-	GError *err = NULL;
+	GError *error = NULL;
+
+	if (query_mtime(locale_filename, time, &error))
+		return TRUE;
+
+	ui_set_statusbar(TRUE, "%s", error->message);
+	g_error_free(error);
+	return FALSE;
+}
+
+
+/* Reads locale_filename into filedata and converts it to UTF-8 from forced_enc, or from the
+ * detected encoding if it is NULL. This doesn't touch the UI, so it is also used by the
+ * worker threads prefetching files. On failure, error is set if the file couldn't be read,
+ * and left unset if it couldn't be converted. display_filename can be NULL. */
+static gboolean read_text_file(const gchar *locale_filename, const gchar *display_filename,
+	const gchar *forced_enc, FileData *filedata, GError **error)
+{
+	gboolean converted;
+	ProfilingScope scope;
 
 	filedata->data = NULL;
 	filedata->len = 0;
@@ -986,57 +1048,262 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	filedata->bom = FALSE;
 	filedata->readonly = FALSE;
 
-	if (!get_mtime(locale_filename, &filedata->mtime))
+	if (! query_mtime(locale_filename, &filedata->mtime, error))
 		return FALSE;
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
 		GFile *file = g_file_new_for_path(locale_filename);
+		gboolean loaded = g_file_load_contents(file, NULL, &filedata->data, &filedata->len,
+			NULL, error);
 
-		g_file_load_contents(file, NULL, &filedata->data, &filedata->len, NULL, &err);
 		g_object_unref(file);
+		if (! loaded)
+			return FALSE;
 	}
-	else
-		g_file_get_contents(locale_filename, &filedata->data, &filedata->len, &err);
+	else if (! g_file_get_contents(locale_filename, &filedata->data, &filedata->len, error))
+		return FALSE;
 
-	if (err)
+	profiling_scope_begin(&scope, "document", "encoding detection");
+	converted = encodings_convert_to_utf8_auto(&filedata->data, &filedata->len, forced_enc,
+				&filedata->enc, &filedata->bom, &filedata->readonly);
+	profiling_scope_end(&scope, display_filename);
+	if (! converted)
 	{
-		ui_set_statusbar(TRUE, "%s", err->message);
-		g_error_free(err);
-		return FALSE;
+		g_free(filedata->data);
+		g_free(filedata->enc);
+		filedata->data = NULL;
+		filedata->enc = NULL;
+	}
+	return converted;
+}
+
+
+/* A file read and decoded in advance by a worker thread, see prefetch_files() */
+typedef enum
+{
+	PREFETCH_QUEUED,
+	PREFETCH_READING,
+	PREFETCH_DONE,
+	PREFETCH_TAKEN		/* opened, or being read by the main thread */
+}
+PrefetchState;
+
+typedef struct PrefetchedFile
+{
+	gchar		*locale_filename;
+	FileData	 filedata;
+	gboolean	 loaded;
+	gboolean	 pushed;		/* given to prefetch_pool */
+	PrefetchState state;		/* protected by prefetch_mutex */
+}
+PrefetchedFile;
+
+
+static void prefetched_file_free(gpointer data)
+{
+	PrefetchedFile *file = data;
+
+	if (file->loaded)
+	{
+		g_free(file->filedata.data);
+		g_free(file->filedata.enc);
 	}
+	g_free(file->locale_filename);
+	g_free(file);
+}
+
+
+/* Thread pool function, failures are left for load_text_file() to report when the file
+ * is opened. */
+static void prefetch_file(gpointer data, gpointer user_data)
+{
+	PrefetchedFile *file = data;
+	ProfilingScope scope;
 
-	if (! encodings_convert_to_utf8_auto(&filedata->data, &filedata->len, forced_enc,
-				&filedata->enc, &filedata->bom, &filedata->readonly))
+	g_mutex_lock(&prefetch_mutex);
+	if (file->state != PREFETCH_QUEUED)
 	{
-		if (forced_enc)
-		{
-			ui_set_statusbar(TRUE, _("The file \"%s\" is not valid %s."),
-				display_filename, forced_enc);
-		}
-		else
+		/* the main thread didn't want to wait */
+		g_mutex_unlock(&prefetch_mutex);
+		return;
+	}
+	file->state = PREFETCH_READING;
+	g_mutex_unlock(&prefetch_mutex);
+
+	profiling_scope_begin(&scope, "document", "prefetch");
+	file->loaded = read_text_file(file->locale_filename, NULL, NULL, &file->filedata, NULL);
+	profiling_scope_end(&scope, NULL);
+
+	g_mutex_lock(&prefetch_mutex);
+	file->state = PREFETCH_DONE;
+	g_cond_broadcast(&prefetch_cond);
+	g_mutex_unlock(&prefetch_mutex);
+}
+
+
+/* Lets the worker threads read the next files, but only a few ahead of the file being
+ * opened so that the read files don't pile up in memory. */
+static void prefetch_more_files(void)
+{
+	g_mutex_lock(&prefetch_mutex);
+	while (prefetch_pending < prefetch_ahead && prefetch_queue_pos < prefetch_queue->len)
+	{
+		PrefetchedFile *file = g_ptr_array_index(prefetch_queue, prefetch_queue_pos++);
+
+		if (file->state == PREFETCH_TAKEN)
+			continue;
+		file->pushed = TRUE;
+		prefetch_pending++;
+		g_thread_pool_push(prefetch_pool, file, NULL);
+	}
+	g_mutex_unlock(&prefetch_mutex);
+}
+
+
+/* Starts reading and decoding the files which aren't open yet on worker threads.
+ * Each file is opened as soon as it has been read, see take_prefetched_file(). */
+static void prefetch_files(const gchar * const *locale_filenames)
+{
+	guint i;
+
+	if (prefetched_files == NULL)
+	{
+		gint n_threads;
+
+#if GLIB_CHECK_VERSION(2, 36, 0)
+		n_threads = (gint) g_get_num_processors();
+#else
+		n_threads = 4;
+#endif
+		prefetched_files = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, prefetched_file_free);
+		prefetch_queue = g_ptr_array_new();
+		prefetch_queue_pos = 0;
+		prefetch_pending = 0;
+		prefetch_ahead = (guint) n_threads * 2;
+		prefetch_pool = g_thread_pool_new(prefetch_file, NULL, n_threads, FALSE, NULL);
+	}
+
+	for (i = 0; locale_filenames[i] != NULL; i++)
+	{
+		PrefetchedFile *file;
+		gchar *utf8_filename;
+		gchar *filename;
+
+		/* project files are loaded rather than opened */
+		if (g_str_has_suffix(locale_filenames[i], ".geany"))
+			continue;
+		filename = utils_get_path_from_uri(locale_filenames[i]);
+		if (filename == NULL)
+			continue;
+
+		/* use the same key as document_open_file_full() */
+		utils_tidy_path(filename);
+		utf8_filename = utils_get_utf8_from_locale(filename);
+		if (g_hash_table_contains(prefetched_files, filename) ||
+			document_find_by_filename(utf8_filename) != NULL)
 		{
-			ui_set_statusbar(TRUE,
-	_("The file \"%s\" does not look like a text file or the file encoding is not supported."),
-			display_filename);
+			g_free(utf8_filename);
+			g_free(filename);
+			continue;
 		}
-		g_free(filedata->data);
-		return FALSE;
+		g_free(utf8_filename);
+
+		file = g_new0(PrefetchedFile, 1);
+		file->locale_filename = filename;
+		file->state = PREFETCH_QUEUED;
+		g_hash_table_insert(prefetched_files, filename, file);
+		g_ptr_array_add(prefetch_queue, file);
 	}
+	prefetch_more_files();
+}
 
-	if (filedata->readonly)
-	{
-		const gchar *warn_msg = _(
-			"The file \"%s\" could not be opened properly and has been truncated. " \
-			"This can occur if the file contains a NULL byte. " \
-			"Be aware that saving it can cause data loss.\nThe file was set to read-only.");
 
-		if (main_status.main_window_realized)
-			dialogs_show_msgbox(GTK_MESSAGE_WARNING, warn_msg, display_filename);
+/* Moves the prefetched data of locale_filename to filedata, waiting for it if a worker
+ * thread is reading the file. Returns FALSE if the caller has to read the file. */
+static gboolean take_prefetched_file(const gchar *locale_filename, FileData *filedata)
+{
+	PrefetchedFile *file;
+	PrefetchState state;
+
+	if (prefetched_files == NULL)
+		return FALSE;
+
+	file = g_hash_table_lookup(prefetched_files, locale_filename);
+	if (file == NULL)
+		return FALSE;
+
+	g_mutex_lock(&prefetch_mutex);
+	while (file->state == PREFETCH_READING)
+		g_cond_wait(&prefetch_cond, &prefetch_mutex);
+	/* a file no thread started reading yet is read by the caller */
+	state = file->state;
+	file->state = PREFETCH_TAKEN;
+	g_mutex_unlock(&prefetch_mutex);
+	if (state == PREFETCH_TAKEN)
+		return FALSE;
+
+	/* the entry stays in prefetched_files as prefetch_pool may still refer to it */
+	if (file->pushed)
+		prefetch_pending--;
+	prefetch_more_files();
+
+	if (state != PREFETCH_DONE || ! file->loaded)
+		return FALSE;
+
+	*filedata = file->filedata;
+	file->loaded = FALSE;	/* the data is owned by filedata now */
+	return TRUE;
+}
+
 
-		ui_set_statusbar(TRUE, warn_msg, display_filename);
+static void show_truncated_file_warning(const gchar *display_filename)
+{
+	const gchar *warn_msg = _(
+		"The file \"%s\" could not be opened properly and has been truncated. " \
+		"This can occur if the file contains a NULL byte. " \
+		"Be aware that saving it can cause data loss.\nThe file was set to read-only.");
+
+	if (main_status.main_window_realized)
+		dialogs_show_msgbox(GTK_MESSAGE_WARNING, warn_msg, display_filename);
+
+	ui_set_statusbar(TRUE, warn_msg, display_filename);
+}
+
+
+/* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM. */
+static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
+	FileData *filedata, const gchar *forced_enc)
+{
+	GError *err = NULL;
+
+	if (forced_enc != NULL || ! take_prefetched_file(locale_filename, filedata))
+	{
+		if (! read_text_file(locale_filename, display_filename, forced_enc, filedata, &err))
+		{
+			if (err)
+			{
+				ui_set_statusbar(TRUE, "%s", err->message);
+				g_error_free(err);
+			}
+			else if (forced_enc)
+			{
+				ui_set_statusbar(TRUE, _("The file \"%s\" is not valid %s."),
+					display_filename, forced_enc);
+			}
+			else
+			{
+				ui_set_statusbar(TRUE,
+		_("The file \"%s\" does not look like a text file or the file encoding is not supported."),
+				display_filename);
+			}
+			return FALSE;
+		}
 	}
 
+	if (filedata->readonly)
+		show_truncated_file_warning(display_filename);
+
 	return TRUE;
 }
 
@@ -1288,6 +1555,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc)
 {
 	gint editor_mode;
+	gsize n_lines;
 	gboolean reload = (doc == NULL) ? FALSE : TRUE;
 	gchar *utf8_filename = NULL;
 	gchar *display_filename = NULL;
@@ -1296,6 +1564,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	FileData filedata;
 	UndoReloadData *undo_reload_data;
 	gboolean add_undo_reload_action;
+	ProfilingScope scope;
 
 	g_return_val_if_fail(doc == NULL || doc->is_valid, NULL);
 
@@ -1335,8 +1604,10 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	{	/* doc possibly changed */
 		display_filename = utils_str_middle_truncate(utf8_filename, 100);
 
+		profiling_scope_begin(&scope, "document", reload ? "document reload" : "document open");
 		if (! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
 		{
+			profiling_scope_end(&scope, utf8_filename);
 			g_free(display_filename);
 			g_free(utf8_filename);
 			g_free(locale_filename);
@@ -1370,10 +1641,8 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			 * reloading, and at the end add an UNDO_RELOAD action that performs
 			 * all these actions in bulk. To keep track of how many undo actions
 			 * were added during this time, we compare the current undo-stack height
-			 * with its height at the end of the process. Note that g_trash_stack_height()
-			 * is O(N), which is a little ugly, but this seems like the most maintainable
-			 * option. */
-			undo_reload_data->actions_count = g_trash_stack_height(&doc->priv->undo_actions);
+			 * with its height at the end of the process. */
+			undo_reload_data->actions_count = doc->priv->undo_actions.height;
 
 			/* We use add_undo_reload_action to track any changes to the document that
 			 * require adding an undo action to revert the reload, but that do not
@@ -1381,13 +1650,19 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 			add_undo_reload_action = FALSE;
 		}
 
+		editor_mode = utils_get_line_endings_and_count(filedata.data, filedata.len, &n_lines);
+		/* Let Scintilla allocate its line index in one go rather than growing it while
+		 * inserting the text.  Only do this on an empty document, as setting the text
+		 * first clears the current one, which resets the line index. */
+		if (sci_get_length(doc->editor->sci) == 0)
+			SSM(doc->editor->sci, SCI_ALLOCATELINES, n_lines, 0);
+
 		/* add the text to the ScintillaObject */
 		sci_set_readonly(doc->editor->sci, FALSE);	/* to allow replacing text */
 		sci_set_text(doc->editor->sci, filedata.data);	/* NULL terminated data */
 		queue_colourise(doc);	/* Ensure the document gets colourised. */
 
-		/* detect & set line endings */
-		editor_mode = utils_get_line_endings(filedata.data, filedata.len);
+		/* set line endings */
 		if (undo_reload_data)
 		{
 			undo_reload_data->eol_mode = editor_get_eol_char_mode(doc->editor);
@@ -1440,7 +1715,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 				/* Calculate the number of undo actions that are part of the reloading
 				 * process, and add the UNDO_RELOAD action. */
 				undo_reload_data->actions_count =
-					g_trash_stack_height(&doc->priv->undo_actions) - undo_reload_data->actions_count;
+					doc->priv->undo_actions.height - undo_reload_data->actions_count;
 
 				/* We only add an undo-reload action if the document has actually changed.
 				 * At the time of writing, this condition is moot because sci_set_text
@@ -1469,14 +1744,16 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		/* update taglist, typedef keywords and build menu if necessary */
 		document_set_filetype(doc, use_ft);
 
-		/* set indentation settings after setting the filetype */
+		/* set indentation settings after setting the filetype, restored session files
+		 * get their saved settings instead */
 		if (reload)
 			editor_set_indent(doc->editor, doc->editor->indent_type, doc->editor->indent_width); /* resetup sci */
-		else
+		else if (! defer_loading)
 			document_apply_indent_settings(doc);
 
 		document_set_text_changed(doc, FALSE);	/* also updates tab state */
-		ui_document_show_hide(doc);	/* update the document menu */
+		if (! main_status.opening_batch)
+			ui_document_show_hide(doc);	/* update the document menu */
 
 		/* finally add current file to recent files menu, but not the files from the last session */
 		if (! main_status.opening_session_files)
@@ -1500,6 +1777,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 		/* now the document is fully ready, display it (see notebook_new_tab()) */
 		gtk_widget_show(document_get_notebook_child(doc));
+		profiling_scope_end(&scope, utf8_filename);
 	}
 
 	g_free(display_filename);
@@ -1513,7 +1791,8 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 	/* finally, let the editor widget grab the focus so you can start coding
 	 * right away */
-	g_idle_add(on_idle_focus, doc);
+	if (! main_status.opening_batch)
+		g_idle_add(on_idle_focus, doc);
 	return doc;
 }
 
@@ -1524,6 +1803,7 @@ void document_open_file_list(const gchar *data, gsize length)
 {
 	guint i;
 	gchar **list;
+	GPtrArray *uris = g_ptr_array_new();
 
 	g_return_if_fail(data != NULL);
 
@@ -1531,15 +1811,22 @@ void document_open_file_list(const gchar *data, gsize length)
 
 	/* stop at the end or first empty item, because last item is empty but not null */
 	for (i = 0; list[i] != NULL && list[i][0] != '\0'; i++)
+		g_ptr_array_add(uris, list[i]);
+	g_ptr_array_add(uris, NULL);
+
+	document_begin_batch_open((const gchar * const *) uris->pdata);
+	for (i = 0; i + 1 < uris->len; i++)
 	{
-		gchar *filename = utils_get_path_from_uri(list[i]);
+		gchar *filename = utils_get_path_from_uri(g_ptr_array_index(uris, i));
 
 		if (filename == NULL)
 			continue;
 		document_open_file(filename, FALSE, NULL, NULL);
 		g_free(filename);
 	}
+	document_end_batch_open();
 
+	g_ptr_array_free(uris, TRUE);
 	g_strfreev(list);
 }
 
@@ -1558,11 +1845,24 @@ void document_open_files(const GSList *filenames, gboolean readonly, GeanyFilety
 		const gchar *forced_enc)
 {
 	const GSList *item;
+	GPtrArray *prefetch = g_ptr_array_new();
+
+	/* prefetching only auto-detects the encoding */
+	if (forced_enc == NULL)
+	{
+		for (item = filenames; item != NULL; item = g_slist_next(item))
+			g_ptr_array_add(prefetch, item->data);
+	}
+	g_ptr_array_add(prefetch, NULL);
 
+	document_begin_batch_open((const gchar * const *) prefetch->pdata);
 	for (item = filenames; item != NULL; item = g_slist_next(item))
 	{
 		document_open_file(item->data, readonly, ft, forced_enc);
 	}
+	document_end_batch_open();
+
+	g_ptr_array_free(prefetch, TRUE);
 }
 
 
@@ -1602,6 +1902,10 @@ gboolean document_reload_force(GeanyDocument *doc, const gchar *forced_enc)
 
 	g_return_val_if_fail(doc != NULL, FALSE);
 
+	/* the text can't be replaced while it's written */
+	if (doc->priv->saving)
+		return FALSE;
+
 	/* Cancel resave bar if still open from previous file deletion */
 	if (doc->priv->info_bars[MSG_TYPE_RESAVE] != NULL)
 		gtk_info_bar_response(GTK_INFO_BAR(doc->priv->info_bars[MSG_TYPE_RESAVE]), GTK_RESPONSE_CANCEL);
@@ -1866,6 +2170,44 @@ gboolean document_save_file_as(GeanyDocument *doc, const gchar *utf8_fname)
 }
 
 
+/* pos is the position in the document where conv_error occurred */
+static void show_save_conversion_error(GeanyDocument *doc, GError *conv_error, gint pos)
+{
+	gchar *text = g_strdup_printf(
+_("An error occurred while converting the file from UTF-8 in \"%s\". The file remains unsaved."),
+		doc->encoding);
+	gchar *error_text;
+
+	if (conv_error->code == G_CONVERT_ERROR_ILLEGAL_SEQUENCE)
+	{
+		gint line, column;
+		gint context_len;
+		gunichar unic;
+		/* don't read over the doc length */
+		gint max_len = MIN(pos + 6, sci_get_length(doc->editor->sci));
+		gchar context[7]; /* read 6 bytes from Sci + '\0' */
+		sci_get_text_range(doc->editor->sci, pos, max_len, context);
+
+		/* take only one valid Unicode character from the context and discard the leftover */
+		unic = g_utf8_get_char_validated(context, -1);
+		context_len = g_unichar_to_utf8(unic, context);
+		context[context_len] = '\0';
+		get_line_column_from_pos(doc, pos, &line, &column);
+
+		error_text = g_strdup_printf(
+			_("Error message: %s\nThe error occurred at \"%s\" (line: %d, column: %d)."),
+			conv_error->message, context, line + 1, column);
+	}
+	else
+		error_text = g_strdup_printf(_("Error message: %s."), conv_error->message);
+
+	geany_debug("encoding error: %s", conv_error->message);
+	dialogs_show_msgbox_with_secondary(GTK_MESSAGE_ERROR, text, error_text);
+	g_free(text);
+	g_free(error_text);
+}
+
+
 static gsize save_convert_to_encoding(GeanyDocument *doc, gchar **data, gsize *len)
 {
 	GError *conv_error = NULL;
@@ -1882,39 +2224,8 @@ static gsize save_convert_to_encoding(GeanyDocument *doc, gchar **data, gsize *l
 
 	if (conv_error != NULL)
 	{
-		gchar *text = g_strdup_printf(
-_("An error occurred while converting the file from UTF-8 in \"%s\". The file remains unsaved."),
-			doc->encoding);
-		gchar *error_text;
-
-		if (conv_error->code == G_CONVERT_ERROR_ILLEGAL_SEQUENCE)
-		{
-			gint line, column;
-			gint context_len;
-			gunichar unic;
-			/* don't read over the doc length */
-			gint max_len = MIN((gint)bytes_read + 6, (gint)*len - 1);
-			gchar context[7]; /* read 6 bytes from Sci + '\0' */
-			sci_get_text_range(doc->editor->sci, bytes_read, max_len, context);
-
-			/* take only one valid Unicode character from the context and discard the leftover */
-			unic = g_utf8_get_char_validated(context, -1);
-			context_len = g_unichar_to_utf8(unic, context);
-			context[context_len] = '\0';
-			get_line_column_from_pos(doc, bytes_read, &line, &column);
-
-			error_text = g_strdup_printf(
-				_("Error message: %s\nThe error occurred at \"%s\" (line: %d, column: %d)."),
-				conv_error->message, context, line + 1, column);
-		}
-		else
-			error_text = g_strdup_printf(_("Error message: %s."), conv_error->message);
-
-		geany_debug("encoding error: %s", conv_error->message);
-		dialogs_show_msgbox_with_secondary(GTK_MESSAGE_ERROR, text, error_text);
+		show_save_conversion_error(doc, conv_error, (gint) bytes_read);
 		g_error_free(conv_error);
-		g_free(text);
-		g_free(error_text);
 		return FALSE;
 	}
 	else
@@ -2019,6 +2330,18 @@ static gchar *write_data_to_disk(const gchar *locale_filename,
 }
 
 
+/* to call once the file is on disk */
+static void update_real_path(GeanyDocument *doc, const gchar *locale_filename)
+{
+	if (doc->real_path == NULL)
+	{
+		doc->real_path = utils_get_real_path(locale_filename);
+		doc->priv->is_remote = utils_is_remote_path(locale_filename);
+		monitor_file_setup(doc);
+	}
+}
+
+
 static gchar *save_doc(GeanyDocument *doc, const gchar *locale_filename,
 								 const gchar *data, gsize len)
 {
@@ -2032,55 +2355,577 @@ static gchar *save_doc(GeanyDocument *doc, const gchar *locale_filename,
 		return err;
 
 	/* now the file is on disk, set real_path */
-	if (doc->real_path == NULL)
-	{
-		doc->real_path = utils_get_real_path(locale_filename);
-		doc->priv->is_remote = utils_is_remote_path(locale_filename);
-		monitor_file_setup(doc);
-	}
+	update_real_path(doc, locale_filename);
 	return NULL;
 }
 
 
-static gboolean save_file_handle_infobars(GeanyDocument *doc, gboolean force)
+/* Documents at least this big are written by save_doc_streaming() */
+#define STREAMING_SAVE_MIN_SIZE (8 * 1024 * 1024)
+/* Size of the pieces of text passed to the writer thread */
+#define SAVE_CHUNK_SIZE (1024 * 1024)
+/* Number of pieces of text which may wait to be written */
+#define SAVE_MAX_QUEUED_CHUNKS 4
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+
+#ifdef G_OS_WIN32
+# include <io.h>
+# define fsync _commit
+#endif
+
+typedef enum
 {
-	GtkWidget *bar = NULL;
+	SAVE_MODE_SAFE,		/* write a temporary file and rename it, like g_file_set_contents() */
+	SAVE_MODE_GIO,		/* g_file_replace() */
+	SAVE_MODE_POSIX		/* overwrite the file in place */
+}
+SaveMode;
 
-	document_show_tab(doc);
+/* State shared with the writer thread of save_doc_streaming() */
+typedef struct SaveJob
+{
+	SaveMode	 mode;
+	gboolean	 gio_backup;
+	gchar		*locale_filename;
+	gchar		*display_name;
+	gboolean	 write_bom;
+	GIConv		 conv;			/* (GIConv) -1 to write the text as it is */
+	GAsyncQueue	*chunks;		/* GBytes of text, an empty one ends the file */
+	gint		 written;		/* bytes of text written, accessed atomically */
+	gint		 done;			/* set atomically when the thread has finished */
+	GError		*error;
+	gint		 error_pos;		/* position of the text which couldn't be converted */
+
+	/* only used by the writer thread */
+	gchar		*target_filename;	/* the file replaced by tmp_filename, links resolved */
+	gchar		*tmp_filename;
+	FILE		*fp;
+	GFile		*file;
+	GOutputStream *stream;
+	gchar		*buffer;		/* converted text */
+}
+SaveJob;
 
-	if (doc->priv->info_bars[MSG_TYPE_RELOAD])
-	{
-		if (!dialogs_show_question_full(NULL, _("_Overwrite"), GTK_STOCK_CANCEL,
-			_("Overwrite?"),
-			_("The file '%s' on the disk is more recent than the current buffer."),
-			doc->file_name))
-			return FALSE;
-		bar = doc->priv->info_bars[MSG_TYPE_RELOAD];
-	}
-	else if (doc->priv->info_bars[MSG_TYPE_RESAVE])
+
+static void set_file_error(GError **error, const gchar *format, const gchar *display_name)
+{
+	gint save_errno = errno;
+
+	g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(save_errno), format,
+		display_name, g_strerror(save_errno));
+}
+
+
+static gboolean save_job_open(SaveJob *job)
+{
+	gint fd;
+
+	switch (job->mode)
 	{
-		if (!dialogs_show_question_full(NULL, GTK_STOCK_SAVE, GTK_STOCK_CANCEL,
-			_("Try to resave the file?"),
-			_("File \"%s\" was not found on disk!"),
-			doc->file_name))
-			return FALSE;
-		bar = doc->priv->info_bars[MSG_TYPE_RESAVE];
+		case SAVE_MODE_SAFE:
+		{
+			GStatBuf st;
+			gboolean exists;
+
+			/* write through symlinks instead of replacing them */
+			job->target_filename = utils_get_real_path(job->locale_filename);
+			if (job->target_filename == NULL)
+				job->target_filename = g_strdup(job->locale_filename);
+			exists = g_stat(job->target_filename, &st) == 0;
+
+			/* in the same directory to be able to rename it */
+			job->tmp_filename = g_strconcat(job->target_filename, ".XXXXXX", NULL);
+			errno = 0;
+			fd = g_mkstemp_full(job->tmp_filename, O_WRONLY | O_BINARY, 0666);
+			if (fd == -1)
+			{
+				set_file_error(&job->error, _("Failed to create file '%s': %s"), job->display_name);
+				SETPTR(job->tmp_filename, NULL);
+				return FALSE;
+			}
+#ifdef G_OS_UNIX
+			/* keep the permissions and owner of the original file, like g_file_replace().
+			 * Changing the owner usually needs privileges, so only the group may change;
+			 * ACLs and extended attributes are not copied. */
+			if (exists)
+			{
+				if (fchown(fd, st.st_uid, st.st_gid) != 0 &&
+					fchown(fd, (uid_t) -1, st.st_gid) != 0)
+					geany_debug("Could not keep the owner of %s", job->target_filename);
+				errno = 0;
+				if (fchmod(fd, st.st_mode & 07777) != 0)
+				{
+					set_file_error(&job->error, _("Failed to create file '%s': %s"), job->display_name);
+					close(fd);
+					g_unlink(job->tmp_filename);
+					SETPTR(job->tmp_filename, NULL);
+					return FALSE;
+				}
+			}
+#else
+			(void) exists;
+#endif
+			job->fp = fdopen(fd, "wb");
+			if (job->fp == NULL)
+			{
+				set_file_error(&job->error, _("Failed to create file '%s': %s"), job->display_name);
+				close(fd);
+				return FALSE;
+			}
+			return TRUE;
+		}
+
+		case SAVE_MODE_GIO:
+			job->file = g_file_new_for_path(job->locale_filename);
+			job->stream = G_OUTPUT_STREAM(g_file_replace(job->file, NULL, job->gio_backup,
+				G_FILE_CREATE_NONE, NULL, &job->error));
+			return job->stream != NULL;
+
+		case SAVE_MODE_POSIX:
+			errno = 0;
+			job->fp = g_fopen(job->locale_filename, "wb");
+			if (job->fp == NULL)
+			{
+				set_file_error(&job->error,
+					_("Failed to open file '%s' for writing: fopen() failed: %s"), job->display_name);
+				return FALSE;
+			}
+			return TRUE;
 	}
-	else
+	g_return_val_if_reached(FALSE);
+}
+
+
+static gboolean save_job_write(SaveJob *job, const gchar *data, gsize len)
+{
+	if (job->stream != NULL)
+		return g_output_stream_write_all(job->stream, data, len, NULL, NULL, &job->error);
+
+	errno = 0;
+	if (fwrite(data, sizeof(gchar), len, job->fp) != len)
 	{
-		g_assert_not_reached();
+		set_file_error(&job->error, _("Failed to write file '%s': fwrite() failed: %s"),
+			job->display_name);
 		return FALSE;
 	}
-	gtk_info_bar_response(GTK_INFO_BAR(bar), RESPONSE_DOCUMENT_SAVE);
 	return TRUE;
 }
 
 
-/**
- *  Saves the document.
- *  Also shows the Save As dialog if necessary.
- *  If the file is not modified, this function may do nothing unless @a force is set to @c TRUE.
- *
+/* Writes UTF-8 text starting at document position pos, converted if necessary. */
+static gboolean save_job_write_text(SaveJob *job, const gchar *text, gsize len, gint pos)
+{
+	gchar *inbuf = (gchar *) text;
+	gsize inleft = len;
+
+	if (job->conv == (GIConv) -1)
+		return save_job_write(job, text, len);
+
+	while (inleft > 0)
+	{
+		gchar *outbuf = job->buffer;
+		gsize outleft = SAVE_CHUNK_SIZE;
+		gint save_errno;
+
+		errno = 0;
+		if (g_iconv(job->conv, &inbuf, &inleft, &outbuf, &outleft) == (gsize) -1 &&
+			(save_errno = errno) != E2BIG)
+		{
+			/* chunks don't split characters, so incomplete input is an error as well */
+			job->error_pos = pos + (gint) (inbuf - text);
+			g_set_error_literal(&job->error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
+				g_strerror(save_errno));
+			return FALSE;
+		}
+		if (! save_job_write(job, job->buffer, outbuf - job->buffer))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+/* Finishes the file, or discards it if possible when something failed. */
+static void save_job_close(SaveJob *job)
+{
+	gboolean failed = job->error != NULL;
+
+	if (job->stream != NULL)
+	{
+		GCancellable *cancellable = g_cancellable_new();
+
+		/* a cancelled close keeps the original file */
+		if (failed)
+			g_cancellable_cancel(cancellable);
+		g_output_stream_close(job->stream, cancellable, failed ? NULL : &job->error);
+		g_object_unref(cancellable);
+		g_object_unref(job->stream);
+	}
+	if (job->file != NULL)
+		g_object_unref(job->file);
+
+	if (job->fp != NULL)
+	{
+		errno = 0;
+		/* the data must be on disk before the temporary file replaces the original,
+		 * otherwise a crash could leave an empty file */
+		if (job->tmp_filename != NULL && job->error == NULL &&
+			(fflush(job->fp) != 0 || fsync(fileno(job->fp)) != 0))
+		{
+			set_file_error(&job->error, _("Failed to write file '%s': fsync() failed: %s"),
+				job->display_name);
+		}
+		errno = 0;
+		/* preserve the fwrite() error if any */
+		if (fclose(job->fp) != 0 && job->error == NULL)
+		{
+			set_file_error(&job->error, _("Failed to close file '%s': fclose() failed: %s"),
+				job->display_name);
+		}
+	}
+
+	if (job->tmp_filename != NULL)
+	{
+		errno = 0;
+		if (job->error == NULL && g_rename(job->tmp_filename, job->target_filename) != 0)
+		{
+			set_file_error(&job->error, _("Failed to write file '%s': rename() failed: %s"),
+				job->display_name);
+		}
+		if (job->error != NULL)
+			g_unlink(job->tmp_filename);
+	}
+}
+
+
+static gpointer save_job_thread(gpointer data)
+{
+	static const gchar bom[] = { (gchar) 0xef, (gchar) 0xbb, (gchar) 0xbf };
+	SaveJob *job = data;
+
+	if (save_job_open(job) && (! job->write_bom || save_job_write_text(job, bom, sizeof bom, 0)))
+	{
+		gint pos = 0;
+
+		while (TRUE)
+		{
+			GBytes *chunk = g_async_queue_pop(job->chunks);
+			gsize len;
+			const gchar *text = g_bytes_get_data(chunk, &len);
+			gboolean ok = len == 0 || save_job_write_text(job, text, len, pos);
+
+			g_bytes_unref(chunk);
+			if (! ok || len == 0)
+				break;
+
+			pos += (gint) len;
+			g_atomic_int_set(&job->written, pos);
+			g_main_context_wakeup(NULL);
+		}
+		if (job->error == NULL && job->conv != (GIConv) -1)
+		{
+			/* end any shift sequence of stateful encodings */
+			gchar *outbuf = job->buffer;
+			gsize outleft = SAVE_CHUNK_SIZE;
+
+			g_iconv(job->conv, NULL, NULL, &outbuf, &outleft);
+			save_job_write(job, job->buffer, outbuf - job->buffer);
+		}
+	}
+	save_job_close(job);
+
+	g_atomic_int_set(&job->done, TRUE);
+	g_main_context_wakeup(NULL);
+	return NULL;
+}
+
+
+static void save_job_free(SaveJob *job)
+{
+	if (job->conv != (GIConv) -1)
+		g_iconv_close(job->conv);
+	g_async_queue_unref(job->chunks);
+	if (job->error != NULL)
+		g_error_free(job->error);
+	g_free(job->locale_filename);
+	g_free(job->display_name);
+	g_free(job->target_filename);
+	g_free(job->tmp_filename);
+	g_free(job->buffer);
+	g_free(job);
+}
+
+
+static gboolean save_needs_conversion(GeanyDocument *doc)
+{
+	/* skip when it is already UTF-8 or has the encoding "None" */
+	return doc->encoding != NULL && ! utils_str_equal(doc->encoding, "UTF-8") &&
+		! utils_str_equal(doc->encoding, encodings[GEANY_ENCODING_NONE].charset);
+}
+
+
+/* Whether to save the document with save_doc_streaming() */
+static gboolean use_streaming_save(GeanyDocument *doc)
+{
+	if (sci_get_length(doc->editor->sci) < STREAMING_SAVE_MIN_SIZE)
+		return FALSE;
+
+	/* conversion errors are found while writing, only safe saving keeps the file then */
+	return ! save_needs_conversion(doc) || file_prefs.use_safe_file_saving;
+}
+
+
+static void save_progress_update(GeanyDocument *doc, gint written, gint len)
+{
+	gchar *text;
+
+	if (! interface_prefs.statusbar_visible)
+		return;
+
+	text = g_strdup_printf(_("Saving %s (%d%%)"), DOC_FILENAME(doc),
+		len > 0 ? (gint) (100.0 * written / len) : 100);
+	gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(main_widgets.progressbar),
+		len > 0 ? (gdouble) written / len : 1.0);
+	gtk_progress_bar_set_text(GTK_PROGRESS_BAR(main_widgets.progressbar), text);
+	gtk_widget_show(main_widgets.progressbar);
+	g_free(text);
+}
+
+
+/* Keeps anything from changing documents while the main loop runs for a save, which is only
+ * meant to show the progress. The main window is made insensitive, which also blocks its
+ * keybindings, and the grab keeps input from reaching other windows like the Find dialog.
+ * Commands from other instances wait, and idle callbacks working on documents check
+ * main_status.saving to postpone their work. Calls can be nested. */
+static void block_while_saving(gboolean block)
+{
+	static gint blocked = 0;
+
+	if (block && blocked++ == 0)
+	{
+		main_status.saving = TRUE;
+		gtk_widget_set_sensitive(main_widgets.window, FALSE);
+		gtk_grab_add(main_widgets.window);
+#ifdef HAVE_SOCKET
+		socket_set_input_blocked(TRUE);
+#endif
+	}
+	else if (! block && --blocked == 0)
+	{
+#ifdef HAVE_SOCKET
+		socket_set_input_blocked(FALSE);
+#endif
+		gtk_grab_remove(main_widgets.window);
+		gtk_widget_set_sensitive(main_widgets.window, TRUE);
+		main_status.saving = FALSE;
+
+		/* resume parsing the tags postponed by on_deferred_load_idle() */
+		if (! defer_loading)
+			document_set_defer_loading(FALSE);
+	}
+}
+
+
+/* Writes a big document without copying all of it first. A thread writes and converts
+ * the text piece by piece while the main loop runs to show the progress. The editor
+ * doesn't respond meanwhile, see block_while_saving(). NUL bytes in the text are
+ * written, as when get_save_data() converts the text.
+ * Returns FALSE if the text couldn't be converted to the document's encoding, which has
+ * been reported then. Otherwise errmsg is set to the error message of a failed write. */
+static gboolean save_doc_streaming(GeanyDocument *doc, const gchar *locale_filename,
+		gchar **errmsg)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	const gint len = sci_get_length(sci);
+	gint pos = 0;
+	gboolean show_progress;
+	gboolean converted = TRUE;
+	SaveJob *job;
+	GThread *thread;
+
+	job = g_new0(SaveJob, 1);
+	if (file_prefs.use_safe_file_saving)
+		job->mode = SAVE_MODE_SAFE;
+	else if (USE_GIO_FILE_OPERATIONS)
+		job->mode = SAVE_MODE_GIO;
+	else
+		job->mode = SAVE_MODE_POSIX;
+	job->gio_backup = file_prefs.gio_unsafe_save_backup;
+	job->locale_filename = g_strdup(locale_filename);
+	job->display_name = g_filename_display_name(locale_filename);
+	job->write_bom = doc->has_bom && encodings_is_unicode_charset(doc->encoding);
+	job->conv = (GIConv) -1;
+	job->chunks = g_async_queue_new_full((GDestroyNotify) g_bytes_unref);
+
+	if (save_needs_conversion(doc))
+	{
+		job->conv = g_iconv_open(doc->encoding, "UTF-8");
+		if (job->conv == (GIConv) -1)
+		{
+			GError *error = g_error_new(G_CONVERT_ERROR, G_CONVERT_ERROR_NO_CONVERSION,
+				_("Conversion from %s to %s is not supported."), "UTF-8", doc->encoding);
+
+			show_save_conversion_error(doc, error, 0);
+			g_error_free(error);
+			save_job_free(job);
+			return FALSE;
+		}
+		job->buffer = g_malloc(SAVE_CHUNK_SIZE);
+	}
+
+	/* don't interfere with another user of the progress bar */
+	show_progress = ! gtk_widget_get_visible(main_widgets.progressbar);
+	doc->priv->saving = TRUE;
+	protect_document(doc);
+	block_while_saving(TRUE);
+	/* ignore file changed notification when the file is written */
+	doc->priv->file_disk_status = FILE_IGNORE;
+
+	thread = g_thread_new("geany-save", save_job_thread, job);
+	while (! g_atomic_int_get(&job->done))
+	{
+		if (pos <= len && g_async_queue_length(job->chunks) < SAVE_MAX_QUEUED_CHUNKS)
+		{
+			gint end = MIN(pos + SAVE_CHUNK_SIZE, len);
+			gint i;
+			gchar *text;
+
+			/* Don't split UTF-8 characters when each chunk is converted on its own. A
+			 * character has at most 3 continuation bytes, if there are more the text
+			 * isn't valid UTF-8 anyway and is split where the chunk ends. Chunks are
+			 * never empty before the end of the text. */
+			for (i = 0; job->conv != (GIConv) -1 && i <= 3 && end - i > pos && end - i < len; i++)
+			{
+				if (((guchar) sci_get_char_at(sci, end - i) & 0xc0) != 0x80)
+				{
+					end -= i;
+					break;
+				}
+			}
+			text = sci_get_contents_range(sci, pos, end);
+			g_async_queue_push(job->chunks, g_bytes_new_take(text, end - pos));
+			/* the empty chunk at the end ends the file */
+			pos = (end > pos) ? end : len + 1;
+		}
+		else
+		{
+			if (show_progress)
+				save_progress_update(doc, g_atomic_int_get(&job->written), len);
+			g_main_context_iteration(NULL, TRUE);
+		}
+	}
+	g_thread_join(thread);
+
+	if (show_progress)
+		gtk_widget_hide(main_widgets.progressbar);
+	block_while_saving(FALSE);
+	unprotect_document(doc);
+	doc->priv->saving = FALSE;
+
+	*errmsg = NULL;
+	if (job->error != NULL)
+	{
+		if (job->error->domain == G_CONVERT_ERROR)
+		{
+			show_save_conversion_error(doc, job->error, job->error_pos);
+			doc->priv->file_disk_status = FILE_OK;
+			converted = FALSE;
+		}
+		else
+			*errmsg = g_strdup(job->error->message);
+	}
+	else
+		update_real_path(doc, locale_filename);
+
+	save_job_free(job);
+	return converted;
+}
+
+
+/* Gets the text to save in the document's encoding, or NULL if it couldn't be converted. */
+static gchar *get_save_data(GeanyDocument *doc, gsize *data_len)
+{
+	gchar *data;
+	gsize len;
+
+	len = sci_get_length(doc->editor->sci) + 1;
+	if (doc->has_bom && encodings_is_unicode_charset(doc->encoding))
+	{	/* always write a UTF-8 BOM because in this moment the text itself is still in UTF-8
+		 * encoding, it will be converted to doc->encoding below and this conversion
+		 * also changes the BOM */
+		data = (gchar*) g_malloc(len + 3);	/* 3 chars for BOM */
+		data[0] = (gchar) 0xef;
+		data[1] = (gchar) 0xbb;
+		data[2] = (gchar) 0xbf;
+		sci_get_text(doc->editor->sci, len, data + 3);
+		len += 3;
+	}
+	else
+	{
+		data = (gchar*) g_malloc(len);
+		sci_get_text(doc->editor->sci, len, data);
+	}
+
+	/* save in original encoding */
+	if (save_needs_conversion(doc))
+	{
+		if (! save_convert_to_encoding(doc, &data, &len))
+		{
+			g_free(data);
+			return NULL;
+		}
+	}
+	else
+	{
+		len = strlen(data);
+	}
+
+	*data_len = len;
+	return data;
+}
+
+
+static gboolean save_file_handle_infobars(GeanyDocument *doc, gboolean force)
+{
+	GtkWidget *bar = NULL;
+
+	document_show_tab(doc);
+
+	if (doc->priv->info_bars[MSG_TYPE_RELOAD])
+	{
+		if (!dialogs_show_question_full(NULL, _("_Overwrite"), GTK_STOCK_CANCEL,
+			_("Overwrite?"),
+			_("The file '%s' on the disk is more recent than the current buffer."),
+			doc->file_name))
+			return FALSE;
+		bar = doc->priv->info_bars[MSG_TYPE_RELOAD];
+	}
+	else if (doc->priv->info_bars[MSG_TYPE_RESAVE])
+	{
+		if (!dialogs_show_question_full(NULL, GTK_STOCK_SAVE, GTK_STOCK_CANCEL,
+			_("Try to resave the file?"),
+			_("File \"%s\" was not found on disk!"),
+			doc->file_name))
+			return FALSE;
+		bar = doc->priv->info_bars[MSG_TYPE_RESAVE];
+	}
+	else
+	{
+		g_assert_not_reached();
+		return FALSE;
+	}
+	gtk_info_bar_response(GTK_INFO_BAR(bar), RESPONSE_DOCUMENT_SAVE);
+	return TRUE;
+}
+
+
+/**
+ *  Saves the document.
+ *  Also shows the Save As dialog if necessary.
+ *  If the file is not modified, this function may do nothing unless @a force is set to @c TRUE.
+ *
  *  Saving may include replacing tabs with spaces,
  *  stripping trailing spaces and adding a final new line at the end of the file, depending
  *  on user preferences. Then the @c "document-before-save" signal is emitted,
@@ -2112,6 +2957,10 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 
 	g_return_val_if_fail(doc != NULL, FALSE);
 
+	/* it's already being written */
+	if (doc->priv->saving)
+		return FALSE;
+
 	if (document_need_save_as(doc))
 	{
 		/* ensure doc is the current tab before showing the dialog */
@@ -2148,47 +2997,32 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 	/* notify plugins which may wish to modify the document before it's saved */
 	g_signal_emit_by_name(geany_object, "document-before-save", doc);
 
-	len = sci_get_length(doc->editor->sci) + 1;
-	if (doc->has_bom && encodings_is_unicode_charset(doc->encoding))
-	{	/* always write a UTF-8 BOM because in this moment the text itself is still in UTF-8
-		 * encoding, it will be converted to doc->encoding below and this conversion
-		 * also changes the BOM */
-		data = (gchar*) g_malloc(len + 3);	/* 3 chars for BOM */
-		data[0] = (gchar) 0xef;
-		data[1] = (gchar) 0xbb;
-		data[2] = (gchar) 0xbf;
-		sci_get_text(doc->editor->sci, len, data + 3);
-		len += 3;
-	}
-	else
-	{
-		data = (gchar*) g_malloc(len);
-		sci_get_text(doc->editor->sci, len, data);
-	}
+	locale_filename = utils_get_locale_from_utf8(doc->file_name);
 
-	/* save in original encoding, skip when it is already UTF-8 or has the encoding "None" */
-	if (doc->encoding != NULL && ! utils_str_equal(doc->encoding, "UTF-8") &&
-		! utils_str_equal(doc->encoding, encodings[GEANY_ENCODING_NONE].charset))
+	if (use_streaming_save(doc))
 	{
-		if (! save_convert_to_encoding(doc, &data, &len))
+		if (! save_doc_streaming(doc, locale_filename, &errmsg))
 		{
-			g_free(data);
+			g_free(locale_filename);
 			return FALSE;
 		}
 	}
 	else
 	{
-		len = strlen(data);
-	}
-
-	locale_filename = utils_get_locale_from_utf8(doc->file_name);
+		data = get_save_data(doc, &len);
+		if (data == NULL)
+		{
+			g_free(locale_filename);
+			return FALSE;
+		}
 
-	/* ignore file changed notification when the file is written */
-	doc->priv->file_disk_status = FILE_IGNORE;
+		/* ignore file changed notification when the file is written */
+		doc->priv->file_disk_status = FILE_IGNORE;
 
-	/* actually write the content of data to the file on disk */
-	errmsg = save_doc(doc, locale_filename, data, len);
-	g_free(data);
+		/* actually write the content of data to the file on disk */
+		errmsg = save_doc(doc, locale_filename, data, len);
+		g_free(data);
+	}
 
 	if (errmsg != NULL)
 	{
@@ -2650,10 +3484,15 @@ void document_update_tags(GeanyDocument *doc)
 {
 	guchar *buffer_ptr;
 	gsize len;
+	gboolean new_tm_file = FALSE;
+	ProfilingScope scope;
+	gint64 start = g_get_monotonic_time();
 
 	g_return_if_fail(DOC_VALID(doc));
 	g_return_if_fail(app->tm_workspace != NULL);
 
+	doc->priv->tags_deferred = FALSE;
+
 	/* early out if it's a new file or doesn't support tags */
 	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type))
 	{
@@ -2676,7 +3515,10 @@ void document_update_tags(GeanyDocument *doc)
 		g_free(locale_filename);
 
 		if (doc->tm_file)
+		{
 			tm_workspace_add_source_file_noupdate(doc->tm_file);
+			new_tm_file = TRUE;
+		}
 	}
 
 	/* early out if there's no tm source file and we couldn't create one */
@@ -2693,10 +3535,24 @@ void document_update_tags(GeanyDocument *doc)
 	 * Note: this buffer *MUST NOT* be modified */
 	len = sci_get_length(doc->editor->sci);
 	buffer_ptr = (guchar *) SSM(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
-	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	profiling_scope_begin(&scope, "document", "tag parsing");
+	/* the tags of a freshly opened file are likely in the tag cache, keyed by
+	 * how the unchanged file was read into the buffer */
+	if (new_tm_file && !doc->changed)
+	{
+		gchar *file_key = g_strdup_printf("encoding=%s bom=%d",
+			FALLBACK(doc->encoding, ""), doc->has_bom);
+
+		tm_workspace_update_source_file_buffer_cached(doc->tm_file, buffer_ptr, len, file_key);
+		g_free(file_key);
+	}
+	else
+		tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	profiling_scope_end(&scope, doc->file_name);
 
 	sidebar_update_tag_list(doc, TRUE);
 	document_highlight_tags(doc);
+	profiling_counter_add(PROFILING_COUNTER_UPDATE_TAGS, doc, start, len);
 }
 
 
@@ -2761,6 +3617,10 @@ static gboolean on_document_update_tag_list_idle(gpointer data)
 	if (! DOC_VALID(doc))
 		return FALSE;
 
+	/* try again later, not to parse the document while it is written */
+	if (main_status.saving)
+		return TRUE;
+
 	if (! main_status.quitting)
 		document_update_tags(doc);
 
@@ -2817,7 +3677,215 @@ static void document_load_config(GeanyDocument *doc, GeanyFiletype *type,
 			doc->priv->symbol_list_sort_mode = type->priv->symbol_list_sort_mode;
 	}
 
-	document_update_tags(doc);
+	if (main_status.opening_batch)
+	{
+		doc->priv->tags_deferred = TRUE;
+		g_ptr_array_add(batch_deferred_docs, doc);
+	}
+	else if (defer_loading)
+		doc->priv->tags_deferred = TRUE;
+	else
+		document_update_tags(doc);
+}
+
+
+static GeanyDocument *find_tags_deferred_document(void)
+{
+	guint i;
+
+	foreach_document(i)
+	{
+		if (documents[i]->priv->tags_deferred)
+			return documents[i];
+	}
+	return NULL;
+}
+
+
+/* parses the tags of one deferred document at a time */
+static gboolean on_deferred_load_idle(gpointer data)
+{
+	GeanyDocument *doc;
+
+	/* block_while_saving() resumes when the save is done */
+	if (main_status.quitting || main_status.saving)
+	{
+		deferred_load_source = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	doc = find_tags_deferred_document();
+	if (doc != NULL)
+	{
+		document_update_tags(doc);
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* the current document can now highlight the typenames of all the others */
+	doc = document_get_current();
+	if (doc != NULL)
+		document_highlight_tags(doc);
+
+	deferred_load_source = 0;
+	return G_SOURCE_REMOVE;
+}
+
+
+/* While set, documents being opened postpone parsing their tags and don't detect
+ * their indentation, which is meant for restoring the session (which also restores
+ * the indentation settings). The tags are parsed when a document is first shown,
+ * when a symbol lookup needs them or else in the background after unsetting. */
+void document_set_defer_loading(gboolean defer)
+{
+	defer_loading = defer;
+
+	if (! defer && deferred_load_source == 0 && find_tags_deferred_document() != NULL)
+		deferred_load_source = g_idle_add_full(G_PRIORITY_LOW, on_deferred_load_idle, NULL, NULL);
+}
+
+
+/* Opening many files between these calls reads and decodes locale_filenames in
+ * parallel while they are opened. The documents are added without updating the
+ * notebook page, sidebar selection and menus for each of them, and their tags are
+ * parsed together in document_end_batch_open(), which then updates the UI once for the
+ * current document. The "document-open" signal is still emitted for each document.
+ * locale_filenames is a NULL-terminated list of filenames or URIs, in the order
+ * they will be opened, and can be NULL. Calls can be nested. */
+void document_begin_batch_open(const gchar * const *locale_filenames)
+{
+	if (batch_open_depth++ == 0)
+	{
+		main_status.opening_batch = TRUE;
+		batch_deferred_docs = g_ptr_array_new();
+		sidebar_openfiles_begin_batch();
+	}
+
+	/* a single file is read as usual */
+	if (locale_filenames != NULL && locale_filenames[0] != NULL && locale_filenames[1] != NULL)
+		prefetch_files(locale_filenames);
+}
+
+
+void document_end_batch_open(void)
+{
+	GeanyDocument *doc;
+	guint i;
+
+	g_return_if_fail(batch_open_depth > 0);
+
+	if (--batch_open_depth > 0)
+		return;
+
+	if (prefetched_files != NULL)
+	{
+		/* drop the files not being read yet, only the files being read are waited for */
+		g_thread_pool_free(prefetch_pool, TRUE, TRUE);
+		prefetch_pool = NULL;
+		g_ptr_array_free(prefetch_queue, TRUE);
+		prefetch_queue = NULL;
+		/* files which failed or weren't opened */
+		g_hash_table_destroy(prefetched_files);
+		prefetched_files = NULL;
+	}
+
+	/* parse all the new documents in one workspace update, only the symbol tree
+	 * of the current document is built (see sidebar_update_tag_list()) */
+	tm_workspace_begin_batch_update();
+	for (i = 0; i < batch_deferred_docs->len; i++)
+	{
+		doc = g_ptr_array_index(batch_deferred_docs, i);
+		if (doc->is_valid && doc->priv->tags_deferred)
+			document_update_tags(doc);
+	}
+	tm_workspace_end_batch_update();
+
+	if (batch_deferred_docs->len > 0)
+	{
+		/* type highlighting depends on the tags of all the documents */
+		foreach_document(i)
+			document_highlight_tags(documents[i]);
+	}
+	g_ptr_array_free(batch_deferred_docs, TRUE);
+	batch_deferred_docs = NULL;
+
+	main_status.opening_batch = FALSE;
+	sidebar_openfiles_end_batch();
+	ui_document_buttons_update();
+
+	doc = document_get_current();
+	if (doc != NULL)
+	{
+		/* do the updates skipped on switching pages while opening */
+		document_update_after_switch(doc);
+		g_idle_add(on_idle_focus, doc);
+	}
+}
+
+
+/* Updates the window title, menus, sidebar and so on after switching to doc's notebook page. */
+void document_update_after_switch(GeanyDocument *doc)
+{
+	GtkEntry *filter_entry = GTK_ENTRY(ui_lookup_widget(main_widgets.window, "entry_tagfilter"));
+	const gchar *entry_text = gtk_entry_get_text(filter_entry);
+
+	g_return_if_fail(DOC_VALID(doc));
+
+	document_finish_deferred_load(doc);
+	sidebar_select_openfiles_item(doc);
+	ui_save_buttons_toggle(doc->changed);
+	ui_set_window_title(doc);
+	ui_update_statusbar(doc, -1);
+	ui_update_popup_reundo_items(doc);
+	ui_document_show_hide(doc); /* update the document menu */
+	build_menu_update(doc);
+	if (g_strcmp0(entry_text, doc->priv->tag_filter) != 0)
+	{
+		/* calls sidebar_update_tag_list() in on_entry_tagfilter_changed() */
+		gtk_entry_set_text(filter_entry, doc->priv->tag_filter);
+	}
+	else
+		sidebar_update_tag_list(doc, TRUE);
+	document_highlight_tags(doc);
+
+	document_check_disk_status(doc, TRUE);
+
+#ifdef HAVE_VTE
+	vte_cwd((doc->real_path != NULL) ? doc->real_path : doc->file_name, FALSE);
+#endif
+
+	g_signal_emit_by_name(geany_object, "document-activate", doc);
+}
+
+
+void document_finish_deferred_load(GeanyDocument *doc)
+{
+	g_return_if_fail(DOC_VALID(doc));
+
+	if (doc->priv->tags_deferred)
+		document_update_tags(doc);
+}
+
+
+void document_finish_deferred_loads(void)
+{
+	GeanyDocument *doc;
+	gboolean updated = FALSE;
+	guint i;
+
+	tm_workspace_begin_batch_update();
+	while ((doc = find_tags_deferred_document()) != NULL)
+	{
+		document_update_tags(doc);
+		updated = TRUE;
+	}
+	tm_workspace_end_batch_update();
+
+	/* type highlighting depends on the tags of all the documents */
+	if (updated)
+	{
+		foreach_document(i)
+			document_highlight_tags(documents[i]);
+	}
 }
 
 
@@ -2849,7 +3917,7 @@ void document_set_filetype(GeanyDocument *doc, GeanyFiletype *type)
 
 		/* assume that if previous filetype was none and the settings are the default ones, this
 		 * is the first time the filetype is carefully set, so we should apply indent settings */
-		if ((! old_ft || old_ft->id == GEANY_FILETYPES_NONE) &&
+		if (! defer_loading && (! old_ft || old_ft->id == GEANY_FILETYPES_NONE) &&
 			doc->editor->indent_type == iprefs->type &&
 			doc->editor->indent_width == iprefs->width)
 		{
@@ -2897,33 +3965,129 @@ void document_set_encoding(GeanyDocument *doc, const gchar *new_encoding)
  * to the encoding or the Unicode BOM (which are Scintilla independet).
  * All Scintilla events are stored in the undo / redo buffer and are passed through. */
 
+static void undo_action_free(undo_action *a)
+{
+	switch (a->type)
+	{
+		case UNDO_ENCODING:
+		case UNDO_RELOAD:
+			g_free(a->data); break;
+		default: break;
+	}
+	g_free(a);
+}
+
+
 /* Clears an Undo or Redo buffer. */
-void document_undo_clear_stack(GTrashStack **stack)
+void document_undo_clear_stack(UndoStack *stack)
 {
-	while (g_trash_stack_height(stack) > 0)
+	while (stack->actions != NULL)
 	{
-		undo_action *a = g_trash_stack_pop(stack);
+		undo_action *a = g_trash_stack_pop(&stack->actions);
 
 		if (G_LIKELY(a != NULL))
+			undo_action_free(a);
+	}
+	stack->height = 0;
+}
+
+
+/* Pushes an action, merging it into the top entry if both are UNDO_SCINTILLA. */
+static void undo_stack_push(UndoStack *stack, guint type, gpointer data)
+{
+	undo_action *top = g_trash_stack_peek(&stack->actions);
+
+	if (type == UNDO_SCINTILLA && top != NULL && top->type == UNDO_SCINTILLA)
+		top->count++;
+	else
+	{
+		undo_action *action = g_new0(undo_action, 1);
+
+		action->type = type;
+		action->data = data;
+		action->count = 1;
+		g_trash_stack_push(&stack->actions, action);
+	}
+	stack->height++;
+}
+
+
+/* Pops the top action into @a action.
+ * Returns FALSE if the stack is empty. */
+static gboolean undo_stack_pop(UndoStack *stack, undo_action *action)
+{
+	undo_action *top = g_trash_stack_peek(&stack->actions);
+
+	if (top == NULL)
+		return FALSE;
+
+	*action = *top;
+	if (top->count > 1)
+		top->count--;
+	else
+		g_free(g_trash_stack_pop(&stack->actions));
+	stack->height--;
+	return TRUE;
+}
+
+
+/* Drops the oldest @a steps UNDO_SCINTILLA actions and the actions between them, after
+ * Scintilla dropped as many of its oldest steps. */
+static void undo_stack_drop_oldest(UndoStack *stack, guint steps)
+{
+	GPtrArray *actions = g_ptr_array_new();	/* the top action first */
+	undo_action *a;
+	guint i;
+
+	while ((a = g_trash_stack_pop(&stack->actions)) != NULL)
+		g_ptr_array_add(actions, a);
+
+	for (i = actions->len; i > 0 && steps > 0; i--)
+	{
+		a = g_ptr_array_index(actions, i - 1);
+		if (a->type == UNDO_SCINTILLA && a->count > steps)
 		{
-			switch (a->type)
-			{
-				case UNDO_ENCODING:
-				case UNDO_RELOAD:
-					g_free(a->data); break;
-				default: break;
-			}
-			g_free(a);
+			a->count -= steps;
+			stack->height -= steps;
+			break;
+		}
+		if (a->type == UNDO_SCINTILLA)
+			steps -= a->count;
+		stack->height -= a->count;
+		undo_action_free(a);
+		/* an EOL or reload action can't be undone without the text changes below it */
+		while (steps == 0 && i > 1)
+		{
+			a = g_ptr_array_index(actions, i - 2);
+			if (a->type != UNDO_EOL && a->type != UNDO_RELOAD)
+				break;
+			stack->height -= a->count;
+			undo_action_free(a);
+			i--;
 		}
 	}
-	*stack = NULL;
+
+	for (; i > 0; i--)
+		g_trash_stack_push(&stack->actions, g_ptr_array_index(actions, i - 1));
+	g_ptr_array_free(actions, TRUE);
+}
+
+
+/* Returns the type of the top action, or UNDO_ACTIONS_MAX if the stack is empty. */
+static guint undo_stack_peek_type(UndoStack *stack)
+{
+	undo_action *top = g_trash_stack_peek(&stack->actions);
+
+	return top != NULL ? top->type : UNDO_ACTIONS_MAX;
 }
 
+
 /* Clears the Undo and Redo buffer (to be called when reloading or closing the document) */
 void document_undo_clear(GeanyDocument *doc)
 {
 	document_undo_clear_stack(&doc->priv->undo_actions);
 	document_undo_clear_stack(&doc->priv->redo_actions);
+	doc->priv->undo_memory = 0;
 
 	if (! main_status.quitting && doc->editor != NULL)
 		document_set_text_changed(doc, FALSE);
@@ -2936,15 +4100,9 @@ void document_undo_clear(GeanyDocument *doc)
  * an action from the redo stack to the undo stack. */
 void document_undo_add_internal(GeanyDocument *doc, guint type, gpointer data)
 {
-	undo_action *action;
-
 	g_return_if_fail(doc != NULL);
 
-	action = g_new0(undo_action, 1);
-	action->type = type;
-	action->data = data;
-
-	g_trash_stack_push(&doc->priv->undo_actions, action);
+	undo_stack_push(&doc->priv->undo_actions, type, data);
 
 	/* avoid unnecessary redraws */
 	if (type != UNDO_SCINTILLA || !doc->changed)
@@ -2963,11 +4121,56 @@ void document_undo_add(GeanyDocument *doc, guint type, gpointer data)
 }
 
 
+static gboolean on_undo_trim_idle(gpointer data)
+{
+	GeanyDocument *doc = data;
+	ScintillaObject *sci = doc->editor->sci;
+	gsize limit = (gsize) file_prefs.undo_memory_limit * 1024 * 1024;
+	guint steps;
+
+	doc->priv->undo_trim_source = 0;
+	/* the next modification tries again */
+	if (main_status.saving)
+		return FALSE;
+
+	/* make some room not to do this again after each change */
+	steps = sci_trim_undo_history(sci, limit / 4 * 3);
+	undo_stack_drop_oldest(&doc->priv->undo_actions, steps);
+	/* the estimate doesn't know about text freed by Scintilla, e.g. the redo steps
+	 * replaced by a new change */
+	doc->priv->undo_memory = sci_get_undo_memory(sci);
+
+	if (steps > 0)
+	{
+		ui_update_popup_reundo_items(doc);
+		msgwin_status_add(_("The oldest %u edits of %s were dropped as the edit history exceeded %d MiB."),
+			steps, DOC_FILENAME(doc), file_prefs.undo_memory_limit);
+	}
+	return FALSE;
+}
+
+
+/* note: this is called on SCN_MODIFIED notifications with the length of the text
+ * Scintilla stored for undo. This only adds up, on_undo_trim_idle() measures the
+ * real size. */
+void document_undo_add_size(GeanyDocument *doc, gsize size)
+{
+	doc->priv->undo_memory += size;
+
+	/* wait until the current action is complete not to split it */
+	if (file_prefs.undo_memory_limit > 0 && doc->priv->undo_trim_source == 0 &&
+		doc->priv->undo_memory / (1024 * 1024) >= (gsize) file_prefs.undo_memory_limit)
+	{
+		doc->priv->undo_trim_source = g_idle_add(on_undo_trim_idle, doc);
+	}
+}
+
+
 gboolean document_can_undo(GeanyDocument *doc)
 {
 	g_return_val_if_fail(doc != NULL, FALSE);
 
-	if (g_trash_stack_height(&doc->priv->undo_actions) > 0 || sci_can_undo(doc->editor->sci))
+	if (doc->priv->undo_actions.height > 0 || sci_can_undo(doc->editor->sci))
 		return TRUE;
 	else
 		return FALSE;
@@ -2986,13 +4189,11 @@ static void update_changed_state(GeanyDocument *doc)
 
 void document_undo(GeanyDocument *doc)
 {
-	undo_action *action;
+	undo_action action;
 
 	g_return_if_fail(doc != NULL);
 
-	action = g_trash_stack_pop(&doc->priv->undo_actions);
-
-	if (G_UNLIKELY(action == NULL))
+	if (G_UNLIKELY(! undo_stack_pop(&doc->priv->undo_actions, &action)))
 	{
 		/* fallback, should not be necessary */
 		geany_debug("%s: fallback used", G_STRFUNC);
@@ -3000,7 +4201,7 @@ void document_undo(GeanyDocument *doc)
 	}
 	else
 	{
-		switch (action->type)
+		switch (action.type)
 		{
 			case UNDO_SCINTILLA:
 			{
@@ -3013,7 +4214,7 @@ void document_undo(GeanyDocument *doc)
 			{
 				document_redo_add(doc, UNDO_BOM, GINT_TO_POINTER(doc->has_bom));
 
-				doc->has_bom = GPOINTER_TO_INT(action->data);
+				doc->has_bom = GPOINTER_TO_INT(action.data);
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
 				break;
@@ -3023,8 +4224,8 @@ void document_undo(GeanyDocument *doc)
 				/* use the "old" encoding */
 				document_redo_add(doc, UNDO_ENCODING, g_strdup(doc->encoding));
 
-				document_set_encoding(doc, (const gchar*)action->data);
-				g_free(action->data);
+				document_set_encoding(doc, (const gchar*)action.data);
+				g_free(action.data);
 
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
@@ -3032,11 +4233,9 @@ void document_undo(GeanyDocument *doc)
 			}
 			case UNDO_EOL:
 			{
-				undo_action *next_action;
-
 				document_redo_add(doc, UNDO_EOL, GINT_TO_POINTER(sci_get_eol_mode(doc->editor->sci)));
 
-				sci_set_eol_mode(doc->editor->sci, GPOINTER_TO_INT(action->data));
+				sci_set_eol_mode(doc->editor->sci, GPOINTER_TO_INT(action.data));
 
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
@@ -3044,14 +4243,13 @@ void document_undo(GeanyDocument *doc)
 				/* When undoing, UNDO_EOL is always followed by UNDO_SCINTILLA
 				 * which undos the line endings in the editor and should be
 				 * performed together with UNDO_EOL. */
-				next_action = g_trash_stack_peek(&doc->priv->undo_actions);
-				if (next_action && next_action->type == UNDO_SCINTILLA)
+				if (undo_stack_peek_type(&doc->priv->undo_actions) == UNDO_SCINTILLA)
 					document_undo(doc);
 				break;
 			}
 			case UNDO_RELOAD:
 			{
-				UndoReloadData *data = (UndoReloadData*)action->data;
+				UndoReloadData *data = (UndoReloadData*)action.data;
 				gint eol_mode = data->eol_mode;
 				guint i;
 
@@ -3075,8 +4273,6 @@ void document_undo(GeanyDocument *doc)
 			default: break;
 		}
 	}
-	g_free(action); /* free the action which was taken from the stack */
-
 	update_changed_state(doc);
 	ui_update_popup_reundo_items(doc);
 }
@@ -3086,7 +4282,7 @@ gboolean document_can_redo(GeanyDocument *doc)
 {
 	g_return_val_if_fail(doc != NULL, FALSE);
 
-	if (g_trash_stack_height(&doc->priv->redo_actions) > 0 || sci_can_redo(doc->editor->sci))
+	if (doc->priv->redo_actions.height > 0 || sci_can_redo(doc->editor->sci))
 		return TRUE;
 	else
 		return FALSE;
@@ -3095,13 +4291,11 @@ gboolean document_can_redo(GeanyDocument *doc)
 
 void document_redo(GeanyDocument *doc)
 {
-	undo_action *action;
+	undo_action action;
 
 	g_return_if_fail(doc != NULL);
 
-	action = g_trash_stack_pop(&doc->priv->redo_actions);
-
-	if (G_UNLIKELY(action == NULL))
+	if (G_UNLIKELY(! undo_stack_pop(&doc->priv->redo_actions, &action)))
 	{
 		/* fallback, should not be necessary */
 		geany_debug("%s: fallback used", G_STRFUNC);
@@ -3109,12 +4303,10 @@ void document_redo(GeanyDocument *doc)
 	}
 	else
 	{
-		switch (action->type)
+		switch (action.type)
 		{
 			case UNDO_SCINTILLA:
 			{
-				undo_action *next_action;
-
 				document_undo_add_internal(doc, UNDO_SCINTILLA, NULL);
 
 				sci_redo(doc->editor->sci);
@@ -3122,8 +4314,7 @@ void document_redo(GeanyDocument *doc)
 				/* When redoing an EOL change, the UNDO_SCINTILLA which changes
 				 * the line ends in the editor is followed by UNDO_EOL
 				 * which should be performed together with UNDO_SCINTILLA. */
-				next_action = g_trash_stack_peek(&doc->priv->redo_actions);
-				if (next_action != NULL && next_action->type == UNDO_EOL)
+				if (undo_stack_peek_type(&doc->priv->redo_actions) == UNDO_EOL)
 					document_redo(doc);
 				break;
 			}
@@ -3131,7 +4322,7 @@ void document_redo(GeanyDocument *doc)
 			{
 				document_undo_add_internal(doc, UNDO_BOM, GINT_TO_POINTER(doc->has_bom));
 
-				doc->has_bom = GPOINTER_TO_INT(action->data);
+				doc->has_bom = GPOINTER_TO_INT(action.data);
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
 				break;
@@ -3140,8 +4331,8 @@ void document_redo(GeanyDocument *doc)
 			{
 				document_undo_add_internal(doc, UNDO_ENCODING, g_strdup(doc->encoding));
 
-				document_set_encoding(doc, (const gchar*)action->data);
-				g_free(action->data);
+				document_set_encoding(doc, (const gchar*)action.data);
+				g_free(action.data);
 
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
@@ -3151,7 +4342,7 @@ void document_redo(GeanyDocument *doc)
 			{
 				document_undo_add_internal(doc, UNDO_EOL, GINT_TO_POINTER(sci_get_eol_mode(doc->editor->sci)));
 
-				sci_set_eol_mode(doc->editor->sci, GPOINTER_TO_INT(action->data));
+				sci_set_eol_mode(doc->editor->sci, GPOINTER_TO_INT(action.data));
 
 				ui_update_statusbar(doc, -1);
 				ui_document_show_hide(doc);
@@ -3159,7 +4350,7 @@ void document_redo(GeanyDocument *doc)
 			}
 			case UNDO_RELOAD:
 			{
-				UndoReloadData *data = (UndoReloadData*)action->data;
+				UndoReloadData *data = (UndoReloadData*)action.data;
 				gint eol_mode = data->eol_mode;
 				guint i;
 
@@ -3183,8 +4374,6 @@ void document_redo(GeanyDocument *doc)
 			default: break;
 		}
 	}
-	g_free(action); /* free the action which was taken from the stack */
-
 	update_changed_state(doc);
 	ui_update_popup_reundo_items(doc);
 }
@@ -3192,15 +4381,9 @@ void document_redo(GeanyDocument *doc)
 
 static void document_redo_add(GeanyDocument *doc, guint type, gpointer data)
 {
-	undo_action *action;
-
 	g_return_if_fail(doc != NULL);
 
-	action = g_new0(undo_action, 1);
-	action->type = type;
-	action->data = data;
-
-	g_trash_stack_push(&doc->priv->redo_actions, action);
+	undo_stack_push(&doc->priv->redo_actions, type, data);
 
 	if (type != UNDO_SCINTILLA || !doc->changed)
 		document_set_text_changed(doc, TRUE);
@@ -3369,6 +4552,11 @@ gboolean document_account_for_unsaved(void)
 	{
 		GeanyDocument *doc = document_get_from_page(p);
 
+		if (DOC_VALID(doc) && doc->priv->saving)
+		{
+			ui_set_statusbar(TRUE, _("The file \"%s\" is still being saved."), DOC_FILENAME(doc));
+			return FALSE;
+		}
 		if (DOC_VALID(doc) && doc->changed)
 		{
 			if (! dialogs_show_unsaved_file(doc))
@@ -67,6 +67,9 @@ typedef struct GeanyFilePrefs
 	gboolean		show_keep_edit_history_on_reload_msg; /* whether to show the message introducing the above feature */
  	gboolean		reload_clean_doc_on_file_change;
  	gboolean		save_config_on_file_change;
+	gboolean		lazy_session_loading; /* postpone parsing tags of restored session files */
+	gboolean		use_tag_cache; /* store the tags of parsed files on disk to reuse them */
+	gint			undo_memory_limit; /* in MiB, discard the edit history above this, 0 for no limit */
 }
 GeanyFilePrefs;
 
@@ -255,6 +258,18 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 void document_open_file_list(const gchar *data, gsize length);
 
+void document_set_defer_loading(gboolean defer);
+
+void document_finish_deferred_load(GeanyDocument *doc);
+
+void document_finish_deferred_loads(void);
+
+void document_begin_batch_open(const gchar * const *locale_filenames);
+
+void document_end_batch_open(void);
+
+void document_update_after_switch(GeanyDocument *doc);
+
 gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolean inc,
 		gboolean backwards);
 
@@ -293,6 +308,8 @@ void document_redo(GeanyDocument *doc);
 
 void document_undo_add(GeanyDocument *doc, guint type, gpointer data);
 
+void document_undo_add_size(GeanyDocument *doc, gsize size);
+
 void document_update_tab_label(GeanyDocument *doc);
 
 const gchar *document_get_status_widget_class(GeanyDocument *doc);
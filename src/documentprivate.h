@@ -45,6 +45,15 @@ typedef struct UndoReloadData
 }
 UndoReloadData;
 
+/* An undo or redo stack. Consecutive UNDO_SCINTILLA actions share a single entry,
+ * so the stack stays small however long the editing session is. */
+typedef struct UndoStack
+{
+	GTrashStack	*actions;
+	guint		 height;	/* number of actions, counting each coalesced one */
+}
+UndoStack;
+
 typedef enum
 {
 	FILE_OK,
@@ -84,9 +93,9 @@ typedef struct GeanyDocumentPrivate
 	/* Iter for this document within the Open Files treeview of the sidebar. */
 	GtkTreeIter		 iter;
 	/* Used by the Undo/Redo management code. */
-	GTrashStack		*undo_actions;
+	UndoStack		 undo_actions;
 	/* Used by the Undo/Redo management code. */
-	GTrashStack		*redo_actions;
+	UndoStack		 redo_actions;
 	/* Used so Undo/Redo works for encoding changes. */
 	FileEncoding	 saved_encoding;
 	gboolean		 colourise_needed;	/* use document.c:queue_colourise() instead */
@@ -105,15 +114,27 @@ typedef struct GeanyDocumentPrivate
 	time_t			 mtime;
 	/* ID of the idle callback updating the tag list */
 	guint			 tag_list_update_source;
+	/* ID of the idle callback colourising big documents in chunks */
+	guint			 colourise_source;
+	/* Approximate size of the text Scintilla keeps for undo and redo, see document_undo_add_size() */
+	gsize			 undo_memory;
+	/* ID of the idle callback discarding the edit history when it got too big */
+	guint			 undo_trim_source;
+	/* Whether parsing the tags was postponed, see document_set_defer_loading() */
+	gboolean		 tags_deferred;
 	/* Whether it's temporarily protected (read-only and saving needs confirmation). Does
 	 * not imply doc->readonly as writable files can be protected */
 	gint			 protected;
+	/* Whether the document is being written to disk by save_doc_streaming() */
+	gboolean		 saving;
 	/* Save pointer to info bars allowing to cancel them programatically (to avoid multiple ones) */
 	GtkWidget		*info_bars[NUM_MSG_TYPES];
 	/* Keyed Data List to attach arbitrary data to the document */
 	GData			*data;
 	/* Text used for filtering symbol tree. */
 	gchar			*tag_filter;
+	/* Performance counters, allocated on first use (see profiling.c) */
+	struct GeanyPerfStats *perf_stats;
 }
 GeanyDocumentPrivate;
 
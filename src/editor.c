@@ -47,6 +47,7 @@
 #include "keybindings.h"
 #include "main.h"
 #include "prefs.h"
+#include "profiling.h"
 #include "projectprivate.h"
 #include "sciwrappers.h"
 #include "support.h"
@@ -70,6 +71,10 @@ static gboolean autocomplete_scope_shown = FALSE;
 
 static const gchar geany_cursor_marker[] = "__GEANY_CURSOR_MARKER__";
 
+/* Documents longer than this are only colourised up to the visible area before being drawn,
+ * the rest is then colourised in chunks of about this size in idle time. */
+#define COLOURISE_CHUNK_SIZE (256 * 1024)
+
 /* holds word under the mouse or keyboard cursor */
 static gchar current_word[GEANY_MAX_WORD_LENGTH];
 
@@ -1124,6 +1129,13 @@ static gboolean on_editor_notify(G_GNUC_UNUSED GObject *object, GeanyEditor *edi
 				/* get notified about undo changes */
 				document_undo_add(doc, UNDO_SCINTILLA, NULL);
 			}
+			if ((nt->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) &&
+				! (nt->modificationType & (SC_PERFORMED_UNDO | SC_PERFORMED_REDO)) &&
+				SSM(sci, SCI_GETUNDOCOLLECTION, 0, 0))
+			{
+				/* the text is kept for undo, undoing and redoing only moves it around */
+				document_undo_add_size(doc, (gsize) nt->length);
+			}
 			if (editor_prefs.folding && (nt->modificationType & SC_MOD_CHANGEFOLD) != 0)
 			{
 				/* handle special fold cases, e.g. #1923350 */
@@ -2161,7 +2173,7 @@ static gboolean autocomplete_doc_word(GeanyEditor *editor, gchar *root, gsize ro
 }
 
 
-gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean force)
+static gboolean start_auto_complete(GeanyEditor *editor, gint pos, gboolean force)
 {
 	gint rootlen, lexer, style;
 	gchar *root;
@@ -2253,6 +2265,19 @@ gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean forc
 }
 
 
+gboolean editor_start_auto_complete(GeanyEditor *editor, gint pos, gboolean force)
+{
+	gint64 start = g_get_monotonic_time();
+	gboolean ret;
+
+	g_return_val_if_fail(editor != NULL, FALSE);
+
+	ret = start_auto_complete(editor, pos, force);
+	profiling_counter_add(PROFILING_COUNTER_AUTO_COMPLETE, editor->document, start, 0);
+	return ret;
+}
+
+
 static const gchar *snippets_find_completion_by_name(const gchar *type, const gchar *name)
 {
 	gchar *result = NULL;
@@ -4302,22 +4327,63 @@ const gchar *editor_get_eol_char(GeanyEditor *editor)
 
 static void fold_all(GeanyEditor *editor, gboolean want_fold)
 {
-	gint lines, first, i;
+	ScintillaObject *sci;
+	gint lines, first, line, level, last_child;
+	gint done_until = -1;
 
 	if (editor == NULL || ! editor_prefs.folding)
 		return;
 
-	lines = sci_get_line_count(editor->sci);
-	first = sci_get_first_visible_line(editor->sci);
+	sci = editor->sci;
+	first = sci_get_first_visible_line(sci);
 
-	for (i = 0; i < lines; i++)
+	/* Toggling each fold point recomputes the visibility of the whole fold every time, so
+	 * set the fold states and the visibility of each fold once instead. */
+	if (want_fold)
 	{
-		gint level = sci_get_fold_level(editor->sci, i);
+		/* the fold levels are only known for the styled text, which might still be
+		 * colourised in idle time */
+		sci_colourise(sci, sci_get_position_from_line(sci,
+			sci_get_line_from_position(sci, sci_get_end_styled(sci))), -1);
 
-		if (level & SC_FOLDLEVELHEADERFLAG)
+		lines = sci_get_line_count(sci);
+		for (line = 0; line < lines; line++)
 		{
-			if (sci_get_fold_expanded(editor->sci, i) == want_fold)
-					sci_toggle_fold(editor->sci, i);
+			level = sci_get_fold_level(sci, line);
+			if (! (level & SC_FOLDLEVELHEADERFLAG))
+				continue;
+
+			sci_set_fold_expanded(sci, line, FALSE);
+			/* nested fold points are already hidden by their contracted parent */
+			if (line > done_until)
+			{
+				last_child = (gint) SSM(sci, SCI_GETLASTCHILD, (uptr_t) line, -1);
+				if (last_child > line)
+				{
+					sci_set_lines_visible(sci, line + 1, last_child, FALSE);
+					done_until = last_child;
+				}
+			}
+		}
+	}
+	else
+	{
+		/* only show the lines hidden by contracted folds, not those hidden otherwise */
+		line = (gint) SSM(sci, SCI_CONTRACTEDFOLDNEXT, 0, 0);
+		while (line >= 0)
+		{
+			sci_set_fold_expanded(sci, line, TRUE);
+			/* nested contracted fold points are shown with their parent */
+			if (line > done_until)
+			{
+				last_child = (gint) SSM(sci, SCI_GETLASTCHILD, (uptr_t) line, -1);
+				if (last_child > line)
+				{
+					sci_set_lines_visible(sci, line + 1, last_child, TRUE);
+					done_until = last_child;
+				}
+			}
+			line = (gint) SSM(sci, SCI_CONTRACTEDFOLDNEXT, (uptr_t) line + 1, 0);
 		}
 	}
 	editor_scroll_to_line(editor, first, 0.0F);
@@ -4724,21 +4790,112 @@ on_editor_scroll_event(GtkWidget *widget, GdkEventScroll *event, gpointer user_d
 }
 
 
+static void on_colourise_done(void)
+{
+	/* now that the current document is colourised, fold points are now accurate,
+	 * so force an update of the current function/tag. */
+	symbols_get_current_function(NULL, NULL);
+	ui_update_statusbar(NULL, -1);
+}
+
+
+/* Colourises the next chunk of a document, starting from the first line that needs it.
+ * Scintilla styles lazily on its own, but fold points and styles of text
+ * that isn't visible are only known once the whole document is colourised. */
+static gboolean on_editor_colourise_idle(gpointer data)
+{
+	GeanyDocument *doc = data;
+	ScintillaObject *sci;
+	gint start, end, length, end_styled;
+	gint64 start_time;
+	ProfilingScope scope;
+
+	if (main_status.quitting || ! DOC_VALID(doc))
+		return FALSE;
+
+	/* editor_check_colourise() starts again when the document is drawn after saving */
+	if (main_status.saving)
+	{
+		doc->priv->colourise_source = 0;
+		doc->priv->colourise_needed = TRUE;
+		return FALSE;
+	}
+
+	sci = doc->editor->sci;
+	length = sci_get_length(sci);
+	end_styled = sci_get_end_styled(sci);
+	start = sci_get_position_from_line(sci, sci_get_line_from_position(sci, end_styled));
+	if (start >= length)
+	{
+		doc->priv->colourise_source = 0;
+		if (doc == document_get_current())
+			on_colourise_done();
+		return FALSE;
+	}
+
+	/* stop at a line start, where the lexer state is well defined */
+	end = start + COLOURISE_CHUNK_SIZE;
+	if (end < length)
+		end = sci_get_position_from_line(sci, sci_get_line_from_position(sci, end) + 1);
+	if (end < 0 || end > length)
+		end = length;
+
+	profiling_scope_begin(&scope, "document", "lexing");
+	start_time = g_get_monotonic_time();
+	sci_colourise(sci, start, end);
+	profiling_counter_add(PROFILING_COUNTER_STYLING, doc, start_time, (gsize) (end - start));
+	profiling_scope_end(&scope, doc->file_name);
+
+	/* don't spin if the lexer got stuck, Scintilla still styles what gets drawn */
+	if (sci_get_end_styled(sci) <= end_styled)
+	{
+		doc->priv->colourise_source = 0;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
 static gboolean editor_check_colourise(GeanyEditor *editor)
 {
 	GeanyDocument *doc = editor->document;
+	ScintillaObject *sci = editor->sci;
+	gint last_line, end;
+	gint64 start;
+	ProfilingScope scope;
 
-	if (!doc->priv->colourise_needed)
+	if (!doc->priv->colourise_needed || main_status.saving)
 		return FALSE;
 
 	doc->priv->colourise_needed = FALSE;
-	sci_colourise(editor->sci, 0, -1);
 
-	/* now that the current document is colourised, fold points are now accurate,
-	 * so force an update of the current function/tag. */
-	symbols_get_current_function(NULL, NULL);
-	ui_update_statusbar(NULL, -1);
+	profiling_scope_begin(&scope, "document", "lexing");
+	start = g_get_monotonic_time();
+	if (sci_get_length(sci) <= COLOURISE_CHUNK_SIZE)
+	{
+		sci_colourise(sci, 0, -1);
+		profiling_counter_add(PROFILING_COUNTER_STYLING, doc, start, (gsize) sci_get_length(sci));
+		profiling_scope_end(&scope, doc->file_name);
+		on_colourise_done();
+		return TRUE;
+	}
 
+	/* Big documents would block the UI for too long, so only colourise the visible part
+	 * now (including the lines above, as the lexer state depends on them) and the rest
+	 * in idle time. */
+	last_line = sci_get_first_visible_line(sci) + (gint) SSM(sci, SCI_LINESONSCREEN, 0, 0);
+	last_line = (gint) SSM(sci, SCI_DOCLINEFROMVISIBLE, (uptr_t) last_line, 0);
+	if (last_line + 1 < sci_get_line_count(sci))
+		end = sci_get_position_from_line(sci, last_line + 1);
+	else
+		end = sci_get_length(sci);
+	sci_colourise(sci, 0, end);
+	profiling_counter_add(PROFILING_COUNTER_STYLING, doc, start, (gsize) end);
+	profiling_scope_end(&scope, doc->file_name);
+
+	if (doc->priv->colourise_source == 0)
+		doc->priv->colourise_source = g_idle_add_full(G_PRIORITY_LOW,
+			on_editor_colourise_idle, doc, NULL);
 	return TRUE;
 }
 
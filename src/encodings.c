@@ -680,6 +680,105 @@ static gchar *encodings_check_regexes(const gchar *buffer, gsize size)
 }
 
 
+/* number of bytes converted to check a charset before converting the whole buffer */
+#define SAMPLE_SIZE 4096
+
+/* Statistics of a buffer to reject most of the charsets it isn't encoded in without
+ * converting all of it, see sample_convertible() */
+typedef struct
+{
+	const gchar	*buffer;
+	gsize		 size;
+	gsize		 first_non_ascii;	/* offset of the first byte >= 0x80, size if none */
+	gboolean	 has_nul;
+	gchar		 bytes[256];		/* each byte value found in buffer once */
+	guint		 n_bytes;
+} BufferSample;
+
+
+static void buffer_sample_init(BufferSample *sample, const gchar *buffer, gsize size)
+{
+	gboolean seen[256] = { FALSE };
+	gsize i;
+	guint c;
+
+	sample->buffer = buffer;
+	sample->size = size;
+	sample->first_non_ascii = size;
+	for (i = 0; i < size; i++)
+	{
+		c = (guchar) buffer[i];
+		if (c >= 0x80 && sample->first_non_ascii == size)
+			sample->first_non_ascii = i;
+		seen[c] = TRUE;
+	}
+	sample->has_nul = seen[0];
+	sample->n_bytes = 0;
+	for (c = 0; c < G_N_ELEMENTS(seen); c++)
+	{
+		if (seen[c])
+			sample->bytes[sample->n_bytes++] = (gchar) c;
+	}
+}
+
+
+/* Converts part of a buffer, accepting a character cut at the end of it. */
+static gboolean convert_part(const gchar *part, gsize size, const gchar *charset)
+{
+	gsize bytes_read, bytes_written;
+	gchar *converted;
+	gboolean ok;
+
+	converted = g_convert(part, size, "UTF-8", charset, &bytes_read, &bytes_written, NULL);
+	/* nul bytes make encodings_convert_to_utf8_from_charset() fail as well */
+	ok = converted != NULL && g_utf8_validate(converted, bytes_written, NULL);
+	g_free(converted);
+	return ok;
+}
+
+
+/* Whether the sampled buffer may be converted from charset, converting as little of it as
+ * possible. When this returns FALSE a full conversion would fail as well, so it doesn't change
+ * which charset gets chosen.
+ * Single byte charsets convert each byte independently, so converting all the byte values
+ * found in the buffer tells the result for the whole buffer. ASCII compatible multibyte charsets
+ * convert any ASCII text except nul bytes, so only the part starting with the first non ASCII
+ * byte is checked. For the others only the start of the buffer is checked. */
+static gboolean sample_convertible(const BufferSample *sample, const gchar *charset)
+{
+	const GeanyEncoding *encoding = encodings_get_from_charset(charset);
+
+	if (encoding != NULL)
+	{
+		switch (encoding->group)
+		{
+			case WESTEUROPEAN:
+			case EASTEUROPEAN:
+			case MIDDLEEASTERN:
+			case ASIAN:
+				return convert_part(sample->bytes, sample->n_bytes, charset);
+
+			case EASTASIAN:
+				/* these are stateful and use ASCII bytes for escape sequences */
+				if (encoding->idx == GEANY_ENCODING_HZ ||
+					encoding->idx == GEANY_ENCODING_ISO_2022_JP ||
+					encoding->idx == GEANY_ENCODING_ISO_2022_KR)
+					break;
+				if (sample->has_nul)
+					return FALSE;
+				if (sample->first_non_ascii == sample->size)
+					return TRUE;
+				return convert_part(sample->buffer + sample->first_non_ascii,
+					MIN(sample->size - sample->first_non_ascii, SAMPLE_SIZE), charset);
+
+			default:
+				break;
+		}
+	}
+	return convert_part(sample->buffer, MIN(sample->size, SAMPLE_SIZE), charset);
+}
+
+
 static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gssize size,
 		const gchar *suggested_charset, gchar **used_encoding)
 {
@@ -689,11 +788,13 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 	gboolean check_suggestion = suggested_charset != NULL;
 	gboolean check_locale = FALSE;
 	gint i, preferred_charset;
+	BufferSample sample;
 
 	if (size == -1)
 	{
 		size = strlen(buffer);
 	}
+	buffer_sample_init(&sample, buffer, size);
 
 	/* current locale is not UTF-8, we have to check this charset */
 	check_locale = ! g_get_charset(&locale_charset);
@@ -746,6 +847,12 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 		if (G_UNLIKELY(charset == NULL))
 			continue;
 
+		if (! sample_convertible(&sample, charset))
+		{
+			geany_debug("Couldn't convert a sample of the data from %s to UTF-8.", charset);
+			continue;
+		}
+
 		geany_debug("Trying to convert %" G_GSIZE_FORMAT " bytes of data from %s into UTF-8.",
 			size, charset);
 		utf8_content = encodings_convert_to_utf8_from_charset(buffer, size, charset, FALSE);
@@ -863,6 +970,41 @@ gboolean encodings_is_unicode_charset(const gchar *string)
 }
 
 
+/* Like g_utf8_validate() for data without nul bytes, but checks ASCII text, which is most of
+ * the text usually, a machine word at a time. */
+static gboolean utf8_validate_fast(const gchar *data, gsize len)
+{
+	const gsize high_bits = (gsize) G_GUINT64_CONSTANT(0x8080808080808080);
+	const gchar *p = data;
+	const gchar *end = data + len;
+
+	while (p < end)
+	{
+		const gchar *run;
+		gsize word;
+
+		/* skip ASCII */
+		while ((gsize) (end - p) >= sizeof word)
+		{
+			memcpy(&word, p, sizeof word);
+			if (word & high_bits)
+				break;
+			p += sizeof word;
+		}
+		while (p < end && (guchar) *p < 0x80)
+			p++;
+
+		/* validate the following non ASCII bytes, which have to be complete characters */
+		run = p;
+		while (p < end && (guchar) *p >= 0x80)
+			p++;
+		if (p > run && ! g_utf8_validate(run, p - run, NULL))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
 typedef struct
 {
 	gchar		*data;	/* null-terminated data */
@@ -882,7 +1024,7 @@ handle_forced_encoding(BufferData *buffer, const gchar *forced_enc)
 
 	if (utils_str_equal(forced_enc, "UTF-8"))
 	{
-		if (! g_utf8_validate(buffer->data, buffer->len, NULL))
+		if (! utf8_validate_fast(buffer->data, buffer->len))
 		{
 			return FALSE;
 		}
@@ -954,7 +1096,7 @@ handle_encoding(BufferData *buffer, GeanyEncodingIndex enc_idx)
 
 			/* try UTF-8 first */
 			if (encodings_get_idx_from_charset(regex_charset) == GEANY_ENCODING_UTF_8 &&
-				(buffer->size == buffer->len) && g_utf8_validate(buffer->data, buffer->len, NULL))
+				(buffer->size == buffer->len) && utf8_validate_fast(buffer->data, buffer->len))
 			{
 				buffer->enc = g_strdup("UTF-8");
 			}
@@ -58,6 +58,14 @@ GPtrArray *filetypes_array = NULL;
 static GHashTable *filetypes_hash = NULL;	/* Hash of filetype pointers based on name keys */
 GSList *filetypes_by_title = NULL;
 
+/* compiled file_prefs.extract_filetype_regex */
+static struct
+{
+	gchar *pattern;
+	GRegex *regex;
+}
+extract_regex;
+
 
 static void create_radio_menu_item(GtkWidget *menu, GeanyFiletype *ftype);
 
@@ -467,28 +475,117 @@ void filetypes_init(void)
 }
 
 
-static guint match_basename(const GeanyFiletype *ft, const gchar *base_filename)
+/* A filename pattern of a filetype in the pattern index */
+typedef struct
+{
+	guint ft_id;
+	guint index;	/* position in the filetype's patterns, the first match counts */
+	guint length;	/* of the pattern, the longest match wins */
+	GPatternSpec *spec;	/* only for patterns not found by hashing */
+}
+FiletypePattern;
+
+/* Filename patterns of all filetypes, so detection doesn't need to glob match each of
+ * them. Patterns without wildcards are found by hashing the basename, "*.ext" ones by
+ * hashing each of its suffixes starting with a dot, only the rest is glob matched. */
+static struct
+{
+	GHashTable *names;		/* literal pattern -> GArray of FiletypePattern */
+	GHashTable *suffixes;	/* ".ext" of "*.ext" -> GArray of FiletypePattern */
+	GArray *globs;			/* FiletypePattern with spec set */
+	guint n_filetypes;		/* filetypes_array->len when built */
+}
+pattern_index;
+
+
+static void pattern_index_clear(void)
+{
+	if (pattern_index.names == NULL)
+		return;
+
+	g_hash_table_destroy(pattern_index.names);
+	g_hash_table_destroy(pattern_index.suffixes);
+	for (guint i = 0; i < pattern_index.globs->len; i++)
+		g_pattern_spec_free(g_array_index(pattern_index.globs, FiletypePattern, i).spec);
+	g_array_free(pattern_index.globs, TRUE);
+	pattern_index.names = NULL;
+}
+
+
+static void pattern_index_add(GHashTable *table, const gchar *key, const FiletypePattern *pat)
+{
+	GArray *pats = g_hash_table_lookup(table, key);
+
+	if (pats == NULL)
+	{
+		pats = g_array_sized_new(FALSE, FALSE, sizeof(FiletypePattern), 1);
+		g_hash_table_insert(table, g_strdup(key), pats);
+	}
+	g_array_append_val(pats, *pat);
+}
+
+
+static void pattern_index_build(void)
 {
-	if (G_UNLIKELY(ft->id == GEANY_FILETYPES_NONE))
-		return 0;
+	pattern_index_clear();
 
-	for (guint j = 0; ft->pattern[j] != NULL; j++)
+	pattern_index.names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify) g_array_unref);
+	pattern_index.suffixes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		(GDestroyNotify) g_array_unref);
+	pattern_index.globs = g_array_new(FALSE, FALSE, sizeof(FiletypePattern));
+	pattern_index.n_filetypes = filetypes_array->len;
+
+	for (guint i = 0; i < filetypes_array->len; i++)
 	{
-		gchar *pat = ft->pattern[j];
-		
-		if (g_pattern_match_simple(pat, base_filename))
+		if (G_UNLIKELY(i == GEANY_FILETYPES_NONE))
+			continue;
+
+		for (guint j = 0; filetypes[i]->pattern[j] != NULL; j++)
 		{
-			return strlen(pat);
+			const gchar *pattern = filetypes[i]->pattern[j];
+			FiletypePattern pat = { i, j, strlen(pattern), NULL };
+
+			if (pat.length == 0)
+				continue;	/* can't contribute to the longest match */
+
+			if (strpbrk(pattern, "*?") == NULL)
+				pattern_index_add(pattern_index.names, pattern, &pat);
+			else if (pattern[0] == '*' && pattern[1] == '.' && strpbrk(pattern + 1, "*?") == NULL)
+				pattern_index_add(pattern_index.suffixes, pattern + 1, &pat);
+			else
+			{
+				pat.spec = g_pattern_spec_new(pattern);
+				g_array_append_val(pattern_index.globs, pat);
+			}
 		}
 	}
-	return 0;
+}
+
+
+static void add_matches(GArray *matches, GArray *pats)
+{
+	if (pats != NULL)
+		g_array_append_vals(matches, pats->data, pats->len);
+}
+
+
+static gint cmp_pattern_matches(gconstpointer a, gconstpointer b)
+{
+	const FiletypePattern *pa = a;
+	const FiletypePattern *pb = b;
+
+	if (pa->ft_id != pb->ft_id)
+		return pa->ft_id < pb->ft_id ? -1 : 1;
+	return pa->index < pb->index ? -1 : (pa->index > pb->index);
 }
 
 
 static GeanyFiletype *detect_filetype_conf_file(const gchar *utf8_filename)
 {
+	/* the filedefs directories don't change while running */
+	static gchar *user_prefix = NULL, *system_prefix = NULL;
 	gchar *lfn = NULL;
-	gchar *path;
 	gboolean found = FALSE;
 
 #ifdef G_OS_WIN32
@@ -499,15 +596,14 @@ static GeanyFiletype *detect_filetype_conf_file(const gchar *utf8_filename)
 #endif
 	SETPTR(lfn, utils_get_locale_from_utf8(lfn));
 
-	path = g_build_filename(app->configdir, GEANY_FILEDEFS_SUBDIR, "filetypes.", NULL);
-	if (g_str_has_prefix(lfn, path))
-		found = TRUE;
-
-	SETPTR(path, g_build_filename(app->datadir, GEANY_FILEDEFS_SUBDIR, "filetypes.", NULL));
-	if (g_str_has_prefix(lfn, path))
+	if (G_UNLIKELY(user_prefix == NULL))
+	{
+		user_prefix = g_build_filename(app->configdir, GEANY_FILEDEFS_SUBDIR, "filetypes.", NULL);
+		system_prefix = g_build_filename(app->datadir, GEANY_FILEDEFS_SUBDIR, "filetypes.", NULL);
+	}
+	if (g_str_has_prefix(lfn, user_prefix) || g_str_has_prefix(lfn, system_prefix))
 		found = TRUE;
 
-	g_free(path);
 	g_free(lfn);
 	return found ? filetypes[GEANY_FILETYPES_CONF] : NULL;
 }
@@ -518,7 +614,9 @@ static GeanyFiletype *detect_filetype_conf_file(const gchar *utf8_filename)
 GeanyFiletype *filetypes_detect_from_extension(const gchar *utf8_filename)
 {
 	gchar *base_filename;
+	const gchar *dot;
 	GeanyFiletype *ft;
+	GArray *matches;
 	guint plen = 0;
 
 	ft = detect_filetype_conf_file(utf8_filename);
@@ -532,21 +630,44 @@ GeanyFiletype *filetypes_detect_from_extension(const gchar *utf8_filename)
 	SETPTR(base_filename, g_utf8_strdown(base_filename, -1));
 #endif
 
-	for (guint i = 0; i < filetypes_array->len; i++)
+	if (pattern_index.names == NULL || pattern_index.n_filetypes != filetypes_array->len)
+		pattern_index_build();
+
+	matches = g_array_new(FALSE, FALSE, sizeof(FiletypePattern));
+	add_matches(matches, g_hash_table_lookup(pattern_index.names, base_filename));
+	for (dot = strchr(base_filename, '.'); dot != NULL; dot = strchr(dot + 1, '.'))
+		add_matches(matches, g_hash_table_lookup(pattern_index.suffixes, dot));
+	for (guint i = 0; i < pattern_index.globs->len; i++)
 	{
-		guint mlen = match_basename(filetypes[i], base_filename);
-		
+		FiletypePattern *pat = &g_array_index(pattern_index.globs, FiletypePattern, i);
+
+		if (g_pattern_match_string(pat->spec, base_filename))
+			g_array_append_val(matches, *pat);
+	}
+
+	/* only the first matching pattern of each filetype counts, in filetype order */
+	g_array_sort(matches, cmp_pattern_matches);
+	for (guint i = 0; i < matches->len; i++)
+	{
+		FiletypePattern *pat = &g_array_index(matches, FiletypePattern, i);
+		guint mlen = pat->length;
+
+		if (i > 0 && g_array_index(matches, FiletypePattern, i - 1).ft_id == pat->ft_id)
+			continue;
+
 		if (mlen > plen)
 		{	// longest pattern match wins
 			plen = mlen;
-			ft = filetypes[i];
+			ft = filetypes[pat->ft_id];
 		}
 		else if (mlen == plen && ft && !ft->priv->user_extensions &&
-			filetypes[i]->priv->user_extensions)
+			filetypes[pat->ft_id]->priv->user_extensions)
 		{	// user config overrides system if pattern len same
-			ft = filetypes[i];
+			ft = filetypes[pat->ft_id];
 		}
 	}
+	g_array_free(matches, TRUE);
+
 	if (ft == NULL)
 		ft = filetypes[GEANY_FILETYPES_NONE];
 
@@ -668,6 +789,31 @@ static GeanyFiletype *find_shebang(const gchar *utf8_filename, const gchar *line
 }
 
 
+/* Returns: the compiled extract_filetype_regex preference, or NULL if invalid.
+ * It is only compiled again when the preference changed. */
+static GRegex *get_extract_filetype_regex(void)
+{
+	GError *error = NULL;
+
+	if (extract_regex.pattern != NULL &&
+		utils_str_equal(extract_regex.pattern, file_prefs.extract_filetype_regex))
+		return extract_regex.regex;
+
+	if (extract_regex.regex != NULL)
+		g_regex_unref(extract_regex.regex);
+	SETPTR(extract_regex.pattern, g_strdup(file_prefs.extract_filetype_regex));
+
+	extract_regex.regex = g_regex_new(file_prefs.extract_filetype_regex,
+			G_REGEX_RAW | G_REGEX_MULTILINE, 0, &error);
+	if (error != NULL)
+	{
+		geany_debug("Filetype extract regex ignored: %s", error->message);
+		g_error_free(error);
+	}
+	return extract_regex.regex;
+}
+
+
 /* Detect the filetype checking for a shebang, then filename extension.
  * @lines: an strv of the lines to scan (must containing at least one line) */
 static GeanyFiletype *filetypes_detect_from_file_internal(const gchar *utf8_filename,
@@ -677,7 +823,6 @@ static GeanyFiletype *filetypes_detect_from_file_internal(const gchar *utf8_file
 	gint			 i;
 	GRegex			*ft_regex;
 	GMatchInfo		*match;
-	GError			*regex_error = NULL;
 
 	/* try to find a shebang and if found use it prior to the filename extension
 	 * also checks for <?xml */
@@ -686,8 +831,7 @@ static GeanyFiletype *filetypes_detect_from_file_internal(const gchar *utf8_file
 		return ft;
 
 	/* try to extract the filetype using a regex capture */
-	ft_regex = g_regex_new(file_prefs.extract_filetype_regex,
-			G_REGEX_RAW | G_REGEX_MULTILINE, 0, &regex_error);
+	ft_regex = get_extract_filetype_regex();
 	if (ft_regex != NULL)
 	{
 		for (i = 0; ft == NULL && lines[i] != NULL; i++)
@@ -703,12 +847,6 @@ static GeanyFiletype *filetypes_detect_from_file_internal(const gchar *utf8_file
 			}
 			g_match_info_free(match);
 		}
-		g_regex_unref(ft_regex);
-	}
-	else if (regex_error != NULL)
-	{
-		geany_debug("Filetype extract regex ignored: %s", regex_error->message);
-		g_error_free(regex_error);
 	}
 	if (ft != NULL)
 		return ft;
@@ -857,6 +995,11 @@ void filetypes_free_types(void)
 	g_return_if_fail(filetypes_array != NULL);
 	g_return_if_fail(filetypes_hash != NULL);
 
+	pattern_index_clear();
+	if (extract_regex.regex != NULL)
+		g_regex_unref(extract_regex.regex);
+	g_free(extract_regex.pattern);
+
 	g_ptr_array_foreach(filetypes_array, filetype_free, NULL);
 	g_ptr_array_free(filetypes_array, TRUE);
 	g_hash_table_destroy(filetypes_hash);
@@ -1403,6 +1546,7 @@ static void read_extensions(GKeyFile *sysconfig, GKeyFile *userconfig)
 		convert_filetype_extensions_to_lower_case(filetypes[i]->pattern, len);
 #endif
 	}
+	pattern_index_clear();
 }
 
 
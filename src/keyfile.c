@@ -261,10 +261,16 @@ static void init_pref_groups(void)
 		"keep_edit_history_on_reload", TRUE);
 	stash_group_add_boolean(group, &file_prefs.show_keep_edit_history_on_reload_msg,
 		"show_keep_edit_history_on_reload_msg", TRUE);
+	stash_group_add_integer(group, &file_prefs.undo_memory_limit,
+		"undo_memory_limit", 0);
 	stash_group_add_boolean(group, &file_prefs.reload_clean_doc_on_file_change,
 		"reload_clean_doc_on_file_change", FALSE);
 	stash_group_add_boolean(group, &file_prefs.save_config_on_file_change,
 		"save_config_on_file_change", TRUE);
+	stash_group_add_boolean(group, &file_prefs.lazy_session_loading,
+		"lazy_session_loading", FALSE);
+	stash_group_add_boolean(group, &file_prefs.use_tag_cache,
+		"use_tag_cache", FALSE);
 	stash_group_add_string(group, &file_prefs.extract_filetype_regex,
 		"extract_filetype_regex", GEANY_DEFAULT_FILETYPE_REGEX);
 	stash_group_add_boolean(group, &ui_prefs.allow_always_save,
@@ -1311,6 +1317,8 @@ void configuration_open_files(void)
 
 	/* necessary to set it to TRUE for project session support */
 	main_status.opening_session_files = TRUE;
+	if (file_prefs.lazy_session_loading)
+		document_set_defer_loading(TRUE);
 
 	i = file_prefs.tab_order_ltr ? 0 : (session_files->len - 1);
 	while (TRUE)
@@ -1342,6 +1350,10 @@ void configuration_open_files(void)
 	g_ptr_array_free(session_files, TRUE);
 	session_files = NULL;
 
+	/* documents shown below load immediately, the others in the background */
+	if (file_prefs.lazy_session_loading)
+		document_set_defer_loading(FALSE);
+
 	if (failure)
 		ui_set_statusbar(TRUE, _("Failed to load one or more session files."));
 	else
@@ -48,6 +48,7 @@
 #include "plugins.h"
 #include "prefs.h"
 #include "printing.h"
+#include "profiling.h"
 #include "sidebar.h"
 #ifdef HAVE_SOCKET
 # include "socket.h"
@@ -113,6 +114,28 @@ static gboolean print_prefix = FALSE;
 static gboolean no_plugins = FALSE;
 #endif
 static gboolean dummy = FALSE;
+static gboolean profile_startup = FALSE;
+static gchar *profile_filename = NULL;
+
+static ProfilingScope startup_scope;
+
+
+static gboolean parse_profile_startup_cb(const gchar *option_name, const gchar *value,
+		gpointer data, GError **error)
+{
+	profile_startup = TRUE;
+	/* resolve now in case the working directory changes (e.g. on Windows) */
+	if (value != NULL && ! g_path_is_absolute(value))
+	{
+		gchar *cur_dir = g_get_current_dir();
+
+		SETPTR(profile_filename, g_build_filename(cur_dir, value, NULL));
+		g_free(cur_dir);
+	}
+	else
+		SETPTR(profile_filename, g_strdup(value));
+	return TRUE;
+}
 
 /* in alphabetical order of short options */
 static GOptionEntry entries[] =
@@ -134,6 +157,7 @@ static GOptionEntry entries[] =
 	{ "no-plugins", 'p', 0, G_OPTION_ARG_NONE, &no_plugins, N_("Don't load plugins"), NULL },
 #endif
 	{ "print-prefix", 0, 0, G_OPTION_ARG_NONE, &print_prefix, N_("Print Geany's installation prefix"), NULL },
+	{ "profile-startup", 0, G_OPTION_FLAG_OPTIONAL_ARG | G_OPTION_FLAG_FILENAME, G_OPTION_ARG_CALLBACK, parse_profile_startup_cb, N_("Write startup timings as a trace to FILE (see documentation)"), N_("FILE") },
 	{ "read-only", 'r', 0, G_OPTION_ARG_NONE, &cl_options.readonly, N_("Open all FILES in read-only mode (see documentation)"), NULL },
 	{ "no-session", 's', G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &cl_options.load_session, N_("Don't load the previous session's files"), NULL },
 #ifdef HAVE_VTE
@@ -264,6 +288,8 @@ static void main_init(void)
 	ui_prefs.recent_queue				= g_queue_new();
 	ui_prefs.recent_projects_queue		= g_queue_new();
 	main_status.opening_session_files	= FALSE;
+	main_status.opening_batch			= FALSE;
+	main_status.saving					= FALSE;
 
 	main_widgets.window = create_window1();
 	g_signal_connect(main_widgets.window, "notify::is-active", G_CALLBACK(on_window_active_changed), NULL);
@@ -865,7 +891,9 @@ gboolean main_handle_filename(const gchar *locale_filename)
 /* open files from command line */
 static void open_cl_files(gint argc, gchar **argv)
 {
+	GPtrArray *filenames = g_ptr_array_new_with_free_func(g_free);
 	gint i;
+	guint j;
 
 	for (i = 1; i < argc; i++)
 	{
@@ -881,7 +909,17 @@ static void open_cl_files(gint argc, gchar **argv)
 		/* It seems argv elements are encoded in CP1252 on a German Windows */
 		SETPTR(filename, g_locale_to_utf8(filename, -1, NULL, NULL, NULL));
 #endif
-		if (filename && ! main_handle_filename(filename))
+		if (filename)
+			g_ptr_array_add(filenames, filename);
+	}
+	g_ptr_array_add(filenames, NULL);
+
+	document_begin_batch_open((const gchar * const *) filenames->pdata);
+	for (j = 0; j + 1 < filenames->len; j++)
+	{
+		const gchar *filename = g_ptr_array_index(filenames, j);
+
+		if (! main_handle_filename(filename))
 		{
 			const gchar *msg = _("Could not find file '%s'.");
 
@@ -889,8 +927,10 @@ static void open_cl_files(gint argc, gchar **argv)
 			g_printerr("\n");
 			ui_set_statusbar(TRUE, msg, filename);
 		}
-		g_free(filename);
 	}
+	document_end_batch_open();
+
+	g_ptr_array_free(filenames, TRUE);
 }
 
 
@@ -989,8 +1029,34 @@ static void load_startup_files(gint argc, gchar **argv)
 }
 
 
+/* Writes the trace recorded since main_lib() was entered and logs a summary of the
+ * startup phases. Recording stops here, the events are kept for later inspection. */
+static void write_startup_profile(void)
+{
+	GError *error = NULL;
+
+	profiling_scope_end(&startup_scope, NULL);
+	profiling_set_enabled(FALSE);
+
+	if (profile_filename == NULL)
+		profile_filename = g_build_filename(g_get_tmp_dir(), "geany-startup-profile.json", NULL);
+
+	profiling_log_report("startup");
+	if (profiling_write_trace(profile_filename, &error))
+		g_message("Startup profile written to %s", profile_filename);
+	else
+	{
+		g_warning("Could not write startup profile: %s", error->message);
+		g_error_free(error);
+	}
+}
+
+
 static gboolean send_startup_complete(gpointer data)
 {
+	if (profile_startup)
+		write_startup_profile();
+
 	g_signal_emit_by_name(geany_object, "geany-startup-complete");
 	return FALSE;
 }
@@ -1014,11 +1080,15 @@ gint main_lib(gint argc, gchar **argv)
 	const gchar *locale;
 	gchar *utf8_configdir;
 	gchar *os_info;
+	ProfilingScope phase;
+	gint64 start_time;
 
 #if ! GLIB_CHECK_VERSION(2, 36, 0)
 	g_type_init();
 #endif
 
+	profiling_init();
+	start_time = g_get_monotonic_time();
 	log_handlers_init();
 
 	app = g_new0(GeanyApp, 1);
@@ -1042,6 +1112,12 @@ gint main_lib(gint argc, gchar **argv)
 	app->tm_workspace = tm_get_workspace();
 	parse_command_line_options(&argc, &argv);
 
+	if (profile_startup)
+	{
+		profiling_set_enabled(TRUE);
+		profiling_scope_begin_at(&startup_scope, "startup", "startup", start_time);
+	}
+
 #if ! GLIB_CHECK_VERSION(2, 32, 0)
 	/* Initialize GLib's thread system in case any plugins want to use it or their
 	 * dependencies (e.g. WebKit, Soup, ...). Deprecated since GLIB 2.32. */
@@ -1056,6 +1132,7 @@ gint main_lib(gint argc, gchar **argv)
 	signal(SIGPIPE, SIG_IGN);
 #endif
 
+	profiling_scope_begin(&phase, "startup", "config dir and socket");
 	config_dir_result = setup_config_dir();
 #ifdef HAVE_SOCKET
 	/* check and create (unix domain) socket for remote operation */
@@ -1073,6 +1150,7 @@ gint main_lib(gint argc, gchar **argv)
 		if ((socket_info.lock_socket == -2 /* socket exists */ && argc > 1) ||
 			cl_options.list_documents)
 		{
+			profiling_finalize();
 			socket_finalize();
 			gdk_notify_startup_complete();
 			g_free(app->configdir);
@@ -1090,6 +1168,7 @@ gint main_lib(gint argc, gchar **argv)
 		}
 	}
 #endif
+	profiling_scope_end(&phase, NULL);
 
 #ifdef G_OS_WIN32
 	/* after we initialized the socket code and handled command line args,
@@ -1117,6 +1196,7 @@ gint main_lib(gint argc, gchar **argv)
 	geany_debug("User config dir: %s", utf8_configdir);
 	g_free(utf8_configdir);
 
+	profiling_scope_begin(&phase, "startup", "core init");
 	/* create the object so Geany signals can be connected in init() functions */
 	geany_object = geany_object_new();
 
@@ -1135,24 +1215,39 @@ gint main_lib(gint argc, gchar **argv)
 	plugins_init();
 #endif
 	sidebar_init();
+	profiling_scope_end(&phase, NULL);
+
+	profiling_scope_begin(&phase, "startup", "load settings");
 	load_settings();	/* load keyfile */
+	profiling_scope_end(&phase, NULL);
 
+	profiling_scope_begin(&phase, "startup", "interface init");
 	msgwin_init();
 	build_init();
 	ui_create_insert_menu_items();
 	ui_create_insert_date_menu_items();
 	keybindings_init();
 	notebook_init();
+	profiling_scope_end(&phase, NULL);
+
+	profiling_scope_begin(&phase, "startup", "filetypes init");
 	filetypes_init();
+	profiling_scope_end(&phase, NULL);
+
+	profiling_scope_begin(&phase, "startup", "templates and symbols init");
 	templates_init();
 	navqueue_init();
 	document_init_doclist();
 	symbols_init();
 	editor_snippets_init();
+	profiling_scope_end(&phase, NULL);
 
 #ifdef HAVE_VTE
+	profiling_scope_begin(&phase, "startup", "terminal init");
 	vte_init();
+	profiling_scope_end(&phase, NULL);
 #endif
+	profiling_scope_begin(&phase, "startup", "apply settings");
 	ui_create_recent_menus();
 
 	ui_set_statusbar(TRUE, _("This is Geany %s."), main_get_version_string());
@@ -1174,13 +1269,17 @@ gint main_lib(gint argc, gchar **argv)
 
 	/* apply all configuration options */
 	apply_settings();
+	profiling_scope_end(&phase, NULL);
 
 #ifdef HAVE_PLUGINS
 	/* load any enabled plugins before we open any documents */
+	profiling_scope_begin(&phase, "startup", "load plugins");
 	if (want_plugins)
 		plugins_load_active();
+	profiling_scope_end(&phase, NULL);
 #endif
 
+	profiling_scope_begin(&phase, "startup", "keybindings and tools");
 	ui_sidebar_show_hide();
 
 	/* set the active sidebar page after plugins have been loaded */
@@ -1192,15 +1291,19 @@ gint main_lib(gint argc, gchar **argv)
 	/* create the custom command menu after the keybindings have been loaded to have the proper
 	 * accelerator shown for the menu items */
 	tools_create_insert_custom_command_menu_items();
+	profiling_scope_end(&phase, NULL);
 
 	/* load any command line files or session files */
+	profiling_scope_begin(&phase, "startup", "open files");
 	main_status.opening_session_files = TRUE;
 	load_startup_files(argc, argv);
 	main_status.opening_session_files = FALSE;
 
 	/* open a new file if no other file was opened */
 	document_new_file_if_non_open();
+	profiling_scope_end(&phase, NULL);
 
+	profiling_scope_begin(&phase, "startup", "show window");
 	ui_document_buttons_update();
 	ui_save_buttons_toggle(FALSE);
 
@@ -1217,6 +1320,7 @@ gint main_lib(gint argc, gchar **argv)
 	main_status.main_window_realized = TRUE;
 
 	configuration_apply_settings();
+	profiling_scope_end(&phase, NULL);
 
 #ifdef HAVE_SOCKET
 	/* register the callback of socket input */
@@ -1296,6 +1400,8 @@ static gboolean do_main_quit(void)
 	configuration_finalize();
 	filetypes_free_types();
 	log_finalize();
+	profiling_finalize();
+	g_free(profile_filename);
 
 	tm_workspace_free();
 	g_free(app->configdir);
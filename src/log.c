@@ -40,6 +40,9 @@
 #endif
 
 static GString *log_buffer = NULL;
+/* messages can be logged from worker threads, e.g. when prefetching files */
+static GMutex log_mutex;
+static GThread *main_thread = NULL;
 static GtkTextBuffer *dialog_textbuffer = NULL;
 
 enum
@@ -55,7 +58,9 @@ static void update_dialog(void)
 		GtkTextMark *mark;
 		GtkTextView *textview = g_object_get_data(G_OBJECT(dialog_textbuffer), "textview");
 
+		g_mutex_lock(&log_mutex);
 		gtk_text_buffer_set_text(dialog_textbuffer, log_buffer->str, log_buffer->len);
+		g_mutex_unlock(&log_mutex);
 		/* scroll to the end of the messages as this might be most interesting */
 		mark = gtk_text_buffer_get_insert(dialog_textbuffer);
 		gtk_text_view_scroll_to_mark(textview, mark, 0.0, FALSE, 0.0, 0.0);
@@ -63,6 +68,27 @@ static void update_dialog(void)
 }
 
 
+static gboolean update_dialog_idle(gpointer data)
+{
+	update_dialog();
+	return G_SOURCE_REMOVE;
+}
+
+
+static void append_to_log(const gchar *msg)
+{
+	g_mutex_lock(&log_mutex);
+	g_string_append(log_buffer, msg);
+	g_mutex_unlock(&log_mutex);
+
+	/* GTK may only be used from the main thread */
+	if (g_thread_self() == main_thread)
+		update_dialog();
+	else
+		g_idle_add(update_dialog_idle, NULL);
+}
+
+
 /* Geany's main debug/log function, declared in geany.h */
 void geany_debug(gchar const *format, ...)
 {
@@ -77,10 +103,7 @@ static void handler_print(const gchar *msg)
 {
 	printf("%s", msg);
 	if (G_LIKELY(log_buffer != NULL))
-	{
-		g_string_append_printf(log_buffer, "%s", msg);
-		update_dialog();
-	}
+		append_to_log(msg);
 }
 
 
@@ -88,10 +111,7 @@ static void handler_printerr(const gchar *msg)
 {
 	fprintf(stderr, "%s", msg);
 	if (G_LIKELY(log_buffer != NULL))
-	{
-		g_string_append_printf(log_buffer, "%s", msg);
-		update_dialog();
-	}
+		append_to_log(msg);
 }
 
 
@@ -118,7 +138,7 @@ static const gchar *get_log_prefix(GLogLevelFlags log_level)
 
 static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *msg, gpointer data)
 {
-	gchar *time_str;
+	gchar *time_str, *text;
 
 	if (G_LIKELY(app != NULL && app->debug_mode) ||
 		! ((G_LOG_LEVEL_DEBUG | G_LOG_LEVEL_INFO | G_LOG_LEVEL_MESSAGE) & level))
@@ -139,18 +159,18 @@ static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *
 
 	time_str = utils_get_current_time_string(TRUE);
 
-	g_string_append_printf(log_buffer, "%s: %s %s: %s\n", time_str, domain,
-		get_log_prefix(level), msg);
+	text = g_strdup_printf("%s: %s %s: %s\n", time_str, domain, get_log_prefix(level), msg);
+	append_to_log(text);
 
+	g_free(text);
 	g_free(time_str);
-
-	update_dialog();
 }
 
 
 void log_handlers_init(void)
 {
 	log_buffer = g_string_sized_new(2048);
+	main_thread = g_thread_self();
 
 	g_set_print_handler(handler_print);
 	g_set_printerr_handler(handler_printerr);
@@ -168,7 +188,9 @@ static void on_dialog_response(GtkDialog *dialog, gint response, gpointer user_d
 		gtk_text_buffer_get_end_iter(dialog_textbuffer, &end_iter);
 		gtk_text_buffer_delete(dialog_textbuffer, &start_iter, &end_iter);
 
+		g_mutex_lock(&log_mutex);
 		g_string_erase(log_buffer, 0, -1);
+		g_mutex_unlock(&log_mutex);
 	}
 	else
 	{
@@ -58,6 +58,8 @@ typedef struct GeanyStatus
 							  * (used to prevent notebook switch page signals) */
 	gboolean	quitting;	/* state when Geany is quitting completely */
 	gboolean	main_window_realized;
+	gboolean	opening_batch;	/* while opening many files, see document_begin_batch_open() */
+	gboolean	saving;		/* while the main loop runs for a document being written */
 }
 GeanyStatus;
 
@@ -0,0 +1,232 @@
+/*
+ *      perfdialog.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The Help->Performance dialog, showing the performance counters kept by profiling.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "perfdialog.h"
+
+#include "documentprivate.h"
+#include "profiling.h"
+#include "support.h"
+#include "ui_utils.h"
+
+#include <gtk/gtk.h>
+
+
+enum
+{
+	STATS_COLUMN_NAME,
+	STATS_COLUMN_CALLS,
+	STATS_COLUMN_TOTAL,
+	STATS_COLUMN_AVERAGE,
+	STATS_COLUMN_MAX,
+	STATS_COLUMN_BYTES,
+	STATS_COLUMN_TOOLTIP,
+	STATS_N_COLUMNS
+};
+
+enum
+{
+	DIALOG_RESPONSE_REFRESH = 1,
+	DIALOG_RESPONSE_RESET
+};
+
+
+/* shown in the dialog, in ProfilingCounter order like profiling_get_counter_names() */
+static const gchar *counter_functions[PROFILING_N_COUNTERS] =
+{
+	"document_update_tags()",
+	"sidebar_update_tag_list()",
+	"editor_start_auto_complete()",
+	"symbols_find_typenames_as_string()",
+	"sci_colourise()"
+};
+
+
+static gchar *format_histogram(const GeanyPerfStats *stats)
+{
+	GString *str = g_string_new(_("Calls by duration:"));
+	guint i;
+
+	for (i = 0; i < GEANY_PERF_HISTOGRAM_SIZE; i++)
+	{
+		if (stats->histogram[i] == 0)
+			continue;
+
+		if (i == 0)
+			g_string_append_printf(str, "\n< 1 ms: ");
+		else if (i == GEANY_PERF_HISTOGRAM_SIZE - 1)
+			g_string_append_printf(str, "\n>= %u ms: ", 1u << (i - 1));
+		else
+			g_string_append_printf(str, "\n%u - %u ms: ", 1u << (i - 1), 1u << i);
+		g_string_append_printf(str, "%" G_GUINT64_FORMAT, stats->histogram[i]);
+	}
+	return g_string_free(str, FALSE);
+}
+
+
+static void set_stats_row(GtkTreeStore *store, GtkTreeIter *iter, const gchar *name,
+		const GeanyPerfStats *stats)
+{
+	gchar *calls = g_strdup_printf("%" G_GUINT64_FORMAT, stats->calls);
+	gchar *total = g_strdup_printf("%.1f", stats->total_time / 1000.0);
+	gchar *average = g_strdup_printf("%.2f",
+		stats->calls > 0 ? stats->total_time / 1000.0 / stats->calls : 0.0);
+	gchar *max = g_strdup_printf("%.1f", stats->max_time / 1000.0);
+	gchar *bytes = stats->bytes > 0 ? g_format_size(stats->bytes) : g_strdup("");
+	gchar *tooltip = format_histogram(stats);
+
+	gtk_tree_store_set(store, iter,
+		STATS_COLUMN_NAME, name,
+		STATS_COLUMN_CALLS, calls,
+		STATS_COLUMN_TOTAL, total,
+		STATS_COLUMN_AVERAGE, average,
+		STATS_COLUMN_MAX, max,
+		STATS_COLUMN_BYTES, bytes,
+		STATS_COLUMN_TOOLTIP, tooltip,
+		-1);
+
+	g_free(calls);
+	g_free(total);
+	g_free(average);
+	g_free(max);
+	g_free(bytes);
+	g_free(tooltip);
+}
+
+
+/* one row per counter, with a child row for each document which used it */
+static void fill_stats_store(GtkTreeStore *store)
+{
+	const gchar * const *names = profiling_get_counter_names();
+	guint i, j;
+
+	gtk_tree_store_clear(store);
+
+	for (i = 0; i < PROFILING_N_COUNTERS; i++)
+	{
+		GtkTreeIter parent, iter;
+
+		gtk_tree_store_append(store, &parent, NULL);
+		set_stats_row(store, &parent, counter_functions[i], profiling_get_stats(names[i], NULL));
+
+		foreach_document(j)
+		{
+			GeanyDocument *doc = documents[j];
+			const GeanyPerfStats *stats = profiling_get_stats(names[i], doc);
+			gchar *name;
+
+			if (stats->calls == 0)
+				continue;
+
+			name = document_get_basename_for_display(doc, -1);
+			gtk_tree_store_append(store, &iter, &parent);
+			set_stats_row(store, &iter, name, stats);
+			g_free(name);
+		}
+	}
+}
+
+
+static void on_stats_dialog_response(GtkDialog *dialog, gint response, gpointer user_data)
+{
+	GtkTreeView *view = user_data;
+	GtkTreeStore *store = GTK_TREE_STORE(gtk_tree_view_get_model(view));
+
+	switch (response)
+	{
+		case DIALOG_RESPONSE_RESET:
+			profiling_reset_stats(NULL);
+			/* fall through */
+		case DIALOG_RESPONSE_REFRESH:
+			fill_stats_store(store);
+			break;
+		default:
+			gtk_widget_destroy(GTK_WIDGET(dialog));
+	}
+}
+
+
+static void add_stats_column(GtkTreeView *view, const gchar *title, gint column, gboolean numeric)
+{
+	GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+	GtkTreeViewColumn *tree_column;
+
+	if (numeric)
+		g_object_set(renderer, "xalign", 1.0, NULL);
+	else
+		g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_MIDDLE, NULL);
+
+	tree_column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", column, NULL);
+	gtk_tree_view_column_set_resizable(tree_column, TRUE);
+	gtk_tree_view_column_set_expand(tree_column, ! numeric);
+	gtk_tree_view_append_column(view, tree_column);
+}
+
+
+void perfdialog_show(void)
+{
+	GtkWidget *dialog, *vbox, *swin, *view;
+	GtkTreeStore *store;
+
+	dialog = gtk_dialog_new_with_buttons(_("Performance"), GTK_WINDOW(main_widgets.window),
+				GTK_DIALOG_DESTROY_WITH_PARENT,
+				_("_Reset"), DIALOG_RESPONSE_RESET,
+				GTK_STOCK_REFRESH, DIALOG_RESPONSE_REFRESH,
+				GTK_STOCK_CLOSE, GTK_RESPONSE_CLOSE, NULL);
+	vbox = ui_dialog_vbox_new(GTK_DIALOG(dialog));
+	gtk_box_set_spacing(GTK_BOX(vbox), 6);
+	gtk_widget_set_name(dialog, "GeanyDialog");
+
+	gtk_window_set_default_size(GTK_WINDOW(dialog), 700, 300);
+	gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_CLOSE);
+
+	store = gtk_tree_store_new(STATS_N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+		G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+	view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(store));
+	g_object_unref(store);
+	gtk_tree_view_set_tooltip_column(GTK_TREE_VIEW(view), STATS_COLUMN_TOOLTIP);
+
+	add_stats_column(GTK_TREE_VIEW(view), _("Operation"), STATS_COLUMN_NAME, FALSE);
+	add_stats_column(GTK_TREE_VIEW(view), _("Calls"), STATS_COLUMN_CALLS, TRUE);
+	add_stats_column(GTK_TREE_VIEW(view), _("Total (ms)"), STATS_COLUMN_TOTAL, TRUE);
+	add_stats_column(GTK_TREE_VIEW(view), _("Average (ms)"), STATS_COLUMN_AVERAGE, TRUE);
+	add_stats_column(GTK_TREE_VIEW(view), _("Max (ms)"), STATS_COLUMN_MAX, TRUE);
+	add_stats_column(GTK_TREE_VIEW(view), _("Data"), STATS_COLUMN_BYTES, TRUE);
+
+	fill_stats_store(store);
+
+	swin = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_shadow_type(GTK_SCROLLED_WINDOW(swin), GTK_SHADOW_IN);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(swin),
+		GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_container_add(GTK_CONTAINER(swin), view);
+
+	gtk_box_pack_start(GTK_BOX(vbox), swin, TRUE, TRUE, 0);
+
+	g_signal_connect(dialog, "response", G_CALLBACK(on_stats_dialog_response), view);
+	gtk_widget_show_all(dialog);
+}
@@ -40,6 +40,7 @@ typedef enum _LoadedFlags {
 	LOADED_OK = 0x01,
 	IS_LEGACY = 0x02,
 	LOAD_DATA = 0x04,
+	IS_CACHED = 0x08,	/* only the info is set, from the metadata cache, the module is not loaded */
 }
 LoadedFlags;
 
@@ -78,6 +79,7 @@ GeanyPluginPrivate;
 #define PLUGIN_LOADED_OK(p) (((p)->flags & LOADED_OK) != 0)
 #define PLUGIN_IS_LEGACY(p) (((p)->flags & IS_LEGACY) != 0)
 #define PLUGIN_HAS_LOAD_DATA(p) (((p)->flags & LOAD_DATA) != 0)
+#define PLUGIN_IS_CACHED(p) (((p)->flags & IS_CACHED) != 0)
 
 void plugin_watch_object(Plugin *plugin, gpointer object);
 void plugin_make_resident(Plugin *plugin);
@@ -44,6 +44,7 @@
 #include "pluginprivate.h"
 #include "pluginutils.h"
 #include "prefs.h"
+#include "profiling.h"
 #include "sciwrappers.h"
 #include "stash.h"
 #include "support.h"
@@ -55,8 +56,13 @@
 #include "win32.h"
 
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
+#ifdef HAVE_LOCALE_H
+# include <locale.h>
+#endif
+
 
 typedef struct
 {
@@ -76,6 +82,9 @@ static gboolean want_plugins = FALSE;
 static GList *plugin_list = NULL;
 static gchar **active_plugins_pref = NULL; 	/* list of plugin filenames to load at startup */
 static GList *failed_plugins_list = NULL;	/* plugins the user wants active but can't be used */
+static GKeyFile *plugin_cache = NULL;		/* metadata of native plugins, see plugin_new_for_list() */
+static GHashTable *plugin_cache_seen = NULL;	/* plugin_cache groups found while listing */
+static gboolean plugin_cache_dirty = FALSE;
 
 static GtkWidget *menu_separator = NULL;
 
@@ -545,7 +554,9 @@ static gboolean
 plugin_load(Plugin *plugin)
 {
 	gboolean init_ok = TRUE;
+	ProfilingScope scope;
 
+	profiling_scope_begin(&scope, "plugin", "plugin init");
 	/* Start the plugin. Legacy plugins require additional cruft. */
 	if (PLUGIN_IS_LEGACY(plugin) && plugin->proxy == &builtin_so_proxy_plugin)
 	{
@@ -579,6 +590,7 @@ plugin_load(Plugin *plugin)
 	{
 		init_ok = plugin->cbs.init(&plugin->public, plugin->cb_data);
 	}
+	profiling_scope_end(&scope, plugin->info.name);
 
 	if (! init_ok)
 		return FALSE;
@@ -987,10 +999,21 @@ plugin_free(Plugin *plugin)
 	active_plugin_list = g_list_remove(active_plugin_list, plugin);
 	plugin_list = g_list_remove(plugin_list, plugin);
 
-	/* cb_data_destroy might be plugin code and must be called before unloading the module. */
-	if (plugin->cb_data_destroy)
-		plugin->cb_data_destroy(plugin->cb_data);
-	proxy->proxy_cbs.unload(&proxy->public, &plugin->public, plugin->proxy_data, proxy->cb_data);
+	if (PLUGIN_IS_CACHED(plugin))
+	{
+		/* nothing was loaded, only the info was read from the cache */
+		g_free((gchar *) plugin->info.name);
+		g_free((gchar *) plugin->info.description);
+		g_free((gchar *) plugin->info.version);
+		g_free((gchar *) plugin->info.author);
+	}
+	else
+	{
+		/* cb_data_destroy might be plugin code and must be called before unloading the module. */
+		if (plugin->cb_data_destroy)
+			plugin->cb_data_destroy(plugin->cb_data);
+		proxy->proxy_cbs.unload(&proxy->public, &plugin->public, plugin->proxy_data, proxy->cb_data);
+	}
 
 	g_free(plugin->filename);
 	g_free(plugin);
@@ -1099,24 +1122,233 @@ static PluginProxy* is_plugin(const gchar *file)
 }
 
 
+/* The plugin manager lists all available plugins, but loading each module only to read
+ * its info is slow with many plugins installed. So the info of native plugins is cached,
+ * keyed by filename and checked against the file's modification time and size. */
+static gchar *get_plugin_cache_filename(void)
+{
+	return g_build_filename(app->configdir, "plugins.cache", NULL);
+}
+
+
+/* The cached plugin names and descriptions are translated, so they are only valid
+ * for the locale they were read with. */
+static const gchar *get_plugin_cache_locale(void)
+{
+	const gchar *locale = NULL;
+#if defined(HAVE_LOCALE_H) && defined(LC_MESSAGES)
+	locale = setlocale(LC_MESSAGES, NULL);
+#endif
+	return locale != NULL ? locale : "";
+}
+
+
+static gboolean plugin_cache_locale_matches(void)
+{
+	gchar *locale = utils_get_setting_string(plugin_cache, "cache", "locale", NULL);
+	gboolean matches = utils_str_equal(locale, get_plugin_cache_locale());
+
+	g_free(locale);
+	return matches;
+}
+
+
+static void plugin_cache_load(void)
+{
+	gchar *fname = get_plugin_cache_filename();
+
+	plugin_cache = g_key_file_new();
+	/* plugins cached for another ABI or API version might not load anymore */
+	if (! g_key_file_load_from_file(plugin_cache, fname, G_KEY_FILE_NONE, NULL) ||
+		utils_get_setting_integer(plugin_cache, "cache", "abi_version", -1) != GEANY_ABI_VERSION ||
+		utils_get_setting_integer(plugin_cache, "cache", "api_version", -1) != GEANY_API_VERSION ||
+		! plugin_cache_locale_matches())
+	{
+		g_key_file_free(plugin_cache);
+		plugin_cache = g_key_file_new();
+		g_key_file_set_integer(plugin_cache, "cache", "abi_version", GEANY_ABI_VERSION);
+		g_key_file_set_integer(plugin_cache, "cache", "api_version", GEANY_API_VERSION);
+		g_key_file_set_string(plugin_cache, "cache", "locale", get_plugin_cache_locale());
+		plugin_cache_dirty = TRUE;
+	}
+	g_free(fname);
+}
+
+
+static void plugin_cache_save(void)
+{
+	gchar **groups, **group;
+	gchar *fname, *data;
+
+	if (plugin_cache == NULL)
+		return;
+
+	/* forget about plugins which were not found anymore */
+	if (plugin_cache_seen != NULL)
+	{
+		groups = g_key_file_get_groups(plugin_cache, NULL);
+		foreach_strv(group, groups)
+		{
+			if (! utils_str_equal(*group, "cache") && ! g_hash_table_contains(plugin_cache_seen, *group))
+			{
+				g_key_file_remove_group(plugin_cache, *group, NULL);
+				plugin_cache_dirty = TRUE;
+			}
+		}
+		g_strfreev(groups);
+	}
+
+	if (! plugin_cache_dirty)
+		return;
+
+	fname = get_plugin_cache_filename();
+	data = g_key_file_to_data(plugin_cache, NULL, NULL);
+	utils_write_file(fname, data);
+	g_free(data);
+	g_free(fname);
+	plugin_cache_dirty = FALSE;
+}
+
+
+static gboolean get_plugin_file_stamp(const gchar *fname, gint64 *mtime, gint64 *size)
+{
+	GStatBuf st;
+
+	if (g_stat(fname, &st) != 0)
+		return FALSE;
+
+	*mtime = st.st_mtime;
+	*size = st.st_size;
+	return TRUE;
+}
+
+
+/* Returns: whether the cache has an up to date entry for fname */
+static gboolean plugin_cache_lookup(const gchar *fname)
+{
+	gint64 mtime, size;
+
+	return g_key_file_has_group(plugin_cache, fname) &&
+		get_plugin_file_stamp(fname, &mtime, &size) &&
+		g_key_file_get_int64(plugin_cache, fname, "mtime", NULL) == mtime &&
+		g_key_file_get_int64(plugin_cache, fname, "size", NULL) == size;
+}
+
+
+static void plugin_cache_add(Plugin *plugin)
+{
+	const gchar *fname = plugin->filename;
+	const gchar *description = plugin->info.description ? plugin->info.description : "";
+	const gchar *version = plugin->info.version ? plugin->info.version : "";
+	const gchar *author = plugin->info.author ? plugin->info.author : "";
+	gint64 mtime, size;
+
+	if (plugin_cache_lookup(fname))
+		return;
+
+	/* group names can't contain brackets, and the file must be valid UTF-8 to be read back */
+	if (strpbrk(fname, "[]") != NULL || ! g_utf8_validate(fname, -1, NULL) ||
+		! g_utf8_validate(plugin->info.name, -1, NULL) || ! g_utf8_validate(description, -1, NULL) ||
+		! g_utf8_validate(version, -1, NULL) || ! g_utf8_validate(author, -1, NULL))
+		return;
+
+	if (! get_plugin_file_stamp(fname, &mtime, &size))
+		return;
+
+	g_key_file_set_int64(plugin_cache, fname, "mtime", mtime);
+	g_key_file_set_int64(plugin_cache, fname, "size", size);
+	g_key_file_set_string(plugin_cache, fname, "name", plugin->info.name);
+	g_key_file_set_string(plugin_cache, fname, "description", description);
+	g_key_file_set_string(plugin_cache, fname, "version", version);
+	g_key_file_set_string(plugin_cache, fname, "author", author);
+	plugin_cache_dirty = TRUE;
+}
+
+
+/* Creates a plugin with only the info set, from the cache. */
+static Plugin *plugin_new_cached(const gchar *fname)
+{
+	Plugin *plugin;
+
+	if (! plugin_cache_lookup(fname))
+		return NULL;
+
+	plugin = g_new0(Plugin, 1);
+	plugin->filename = g_strdup(fname);
+	plugin->proxy = &builtin_so_proxy_plugin;
+	plugin->flags = IS_CACHED;
+	plugin->public.geany_data = &geany_data;
+	plugin->public.priv = plugin;
+	plugin->public.info = &plugin->info;
+	plugin->public.funcs = &plugin->cbs;
+	plugin->public.proxy_funcs = &plugin->proxy_cbs;
+	plugin->info.name = utils_get_setting_string(plugin_cache, fname, "name", "");
+	plugin->info.description = utils_get_setting_string(plugin_cache, fname, "description", "");
+	plugin->info.version = utils_get_setting_string(plugin_cache, fname, "version", "");
+	plugin->info.author = utils_get_setting_string(plugin_cache, fname, "author", "");
+
+	/* let plugin_new() handle these cases, it doesn't load the module for duplicates */
+	if (EMPTY(plugin->info.name) || plugin_loaded(plugin))
+	{
+		plugin_free(plugin);
+		return NULL;
+	}
+	return plugin;
+}
+
+
+/* Creates a plugin for the plugin manager's list. Native plugins which are not active
+ * are created from the cache if possible, so their module is only loaded when they
+ * are activated. */
+static Plugin *plugin_new_for_list(Plugin *proxy, const gchar *fname)
+{
+	Plugin *plugin;
+	gboolean cacheable = proxy == &builtin_so_proxy_plugin && plugin_cache != NULL;
+
+	if (cacheable)
+	{
+		if (plugin_cache_seen != NULL)
+			g_hash_table_add(plugin_cache_seen, g_strdup(fname));
+
+		if (find_active_plugin_by_name(fname) == NULL)
+		{
+			plugin = plugin_new_cached(fname);
+			if (plugin != NULL)
+			{
+				plugin_list = g_list_prepend(plugin_list, plugin);
+				return plugin;
+			}
+		}
+	}
+
+	plugin = plugin_new(proxy, fname, FALSE, TRUE);
+	if (plugin != NULL && cacheable)
+		plugin_cache_add(plugin);
+	return plugin;
+}
+
+
 /* load active plugins at startup */
 static void
 load_active_plugins(void)
 {
 	guint i, len, proxies;
+	/* 0: try (again), 1: loaded or skipped, 2: failed */
+	guint8 *state;
 
 	if (active_plugins_pref == NULL || (len = g_strv_length(active_plugins_pref)) == 0)
 		return;
 
-	/* If proxys are loaded we have to restart to load plugins that sort before their proxy */
+	state = g_new0(guint8, len);
+	/* If proxys are loaded we have to restart to load plugins that sort before their proxy.
+	 * Native plugins which failed won't load any better, so don't load them again */
 	do
 	{
 		proxies = active_proxies.length;
-		g_list_free_full(failed_plugins_list, (GDestroyNotify) g_free);
-		failed_plugins_list = NULL;
 		for (i = 0; i < len; i++)
 		{
 			gchar *fname = active_plugins_pref[i];
+			PluginProxy *proxy = NULL;
 
 #ifdef G_OS_WIN32
 			/* ensure we have canonical paths */
@@ -1125,16 +1357,34 @@ load_active_plugins(void)
 				*p = G_DIR_SEPARATOR;
 #endif
 
-			if (!EMPTY(fname) && g_file_test(fname, G_FILE_TEST_EXISTS))
+			if (state[i] != 0)
+				continue;
+			if (EMPTY(fname) || ! g_file_test(fname, G_FILE_TEST_EXISTS))
 			{
-				PluginProxy *proxy = NULL;
-				if (check_plugin_path(fname))
-					proxy = is_plugin(fname);
-				if (proxy == NULL || plugin_new(proxy->plugin, fname, TRUE, FALSE) == NULL)
-					failed_plugins_list = g_list_prepend(failed_plugins_list, g_strdup(fname));
+				state[i] = 1;
+				continue;
 			}
+
+			if (check_plugin_path(fname))
+				proxy = is_plugin(fname);
+			if (proxy == NULL)
+				continue;
+
+			if (plugin_new(proxy->plugin, fname, TRUE, FALSE) != NULL)
+				state[i] = 1;
+			else if (proxy->plugin == &builtin_so_proxy_plugin)
+				state[i] = 2;
 		}
 	} while (proxies != active_proxies.length);
+
+	g_list_free_full(failed_plugins_list, (GDestroyNotify) g_free);
+	failed_plugins_list = NULL;
+	for (i = 0; i < len; i++)
+	{
+		if (state[i] != 1)
+			failed_plugins_list = g_list_prepend(failed_plugins_list, g_strdup(active_plugins_pref[i]));
+	}
+	g_free(state);
 }
 
 
@@ -1151,7 +1401,7 @@ load_plugins_from_path(const gchar *path)
 		gchar *fname = g_build_filename(path, item->data, NULL);
 		PluginProxy *proxy = is_plugin(fname);
 
-		if (proxy != NULL && plugin_new(proxy->plugin, fname, FALSE, TRUE))
+		if (proxy != NULL && plugin_new_for_list(proxy->plugin, fname))
 			count++;
 
 		g_free(fname);
@@ -1203,6 +1453,10 @@ static void load_all_plugins(void)
 	plugin_path_config = g_build_filename(app->configdir, "plugins", NULL);
 	plugin_path_system = get_plugin_path();
 
+	if (plugin_cache == NULL)
+		plugin_cache_load();
+	plugin_cache_seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
 	/* first load plugins in ~/.config/geany/plugins/ */
 	load_plugins_from_path(plugin_path_config);
 
@@ -1224,6 +1478,10 @@ static void load_all_plugins(void)
 	 * sorting by hierarchy level is perfectly sufficient */
 	plugin_list = g_list_sort(plugin_list, cmp_plugin_by_proxy);
 
+	plugin_cache_save();
+	g_hash_table_destroy(plugin_cache_seen);
+	plugin_cache_seen = NULL;
+
 	g_free(plugin_path_config);
 	g_free(plugin_path_system);
 }
@@ -1369,6 +1627,9 @@ void plugins_finalize(void)
 		g_list_foreach(active_plugin_list, (GFunc) plugin_free_leaf, NULL);
 
 	g_strfreev(active_plugins_pref);
+
+	if (plugin_cache != NULL)
+		g_key_file_free(plugin_cache);
 }
 
 
@@ -1529,7 +1790,10 @@ static void pm_plugin_toggled(GtkCellRendererToggle *cell, gchar *pth, gpointer
 	plugin_free(p);
 
 	/* reload plugin module and initialize it if item is checked */
-	p = plugin_new(proxy, file_name, state, TRUE);
+	if (state)
+		p = plugin_new(proxy, file_name, TRUE, TRUE);
+	else
+		p = plugin_new_for_list(proxy, file_name);
 	if (!p)
 	{
 		/* plugin file may no longer be on disk, or is now incompatible */
@@ -1902,6 +2166,7 @@ static void pm_dialog_response(GtkDialog *dialog, gint response, gpointer user_d
 				g_list_free(plugin_list);
 				plugin_list = NULL;
 			}
+			plugin_cache_save();
 			gtk_widget_destroy(GTK_WIDGET(dialog));
 			pm_widgets.dialog = NULL;
 
@@ -0,0 +1,438 @@
+/*
+ *      profiling.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * In-memory recording of timed regions (startup phases, document loading, plugin
+ * initialisation, ...), written out in the Chrome trace event format so the result can be
+ * inspected with chrome://tracing or Perfetto.
+ * Recording is off by default and then costs a single check per scope.
+ *
+ * Also always-on performance counters of hot paths, kept globally and per document and
+ * shown in the Help->Performance dialog (see perfdialog.c). They are only updated from the
+ * main thread.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "profiling.h"
+
+#include "documentprivate.h"
+
+#include <string.h>
+
+
+/* stop recording rather than growing without bounds if profiling is left enabled */
+#define PROFILING_MAX_EVENTS 100000
+
+typedef struct ProfilingEvent
+{
+	const gchar *category;
+	const gchar *name;
+	gchar *detail;
+	gint64 start;
+	gint64 duration;
+	GThread *thread;
+}
+ProfilingEvent;
+
+
+
+/* names for the plugin API, in ProfilingCounter order */
+static const gchar *counter_names[PROFILING_N_COUNTERS + 1] =
+{
+	"update-tags",
+	"update-tag-list",
+	"auto-complete",
+	"find-typenames",
+	"styling",
+	NULL
+};
+
+static GeanyPerfStats global_stats[PROFILING_N_COUNTERS];
+static const GeanyPerfStats empty_stats;
+
+static gboolean recording = FALSE;
+static gint64 origin_time = 0;
+static GThread *main_thread = NULL;
+static GArray *events = NULL;
+static GMutex events_mutex;
+
+
+void profiling_init(void)
+{
+	origin_time = g_get_monotonic_time();
+	main_thread = g_thread_self();
+	events = g_array_new(FALSE, FALSE, sizeof(ProfilingEvent));
+}
+
+
+void profiling_clear(void)
+{
+	guint i;
+
+	g_return_if_fail(events != NULL);
+
+	g_mutex_lock(&events_mutex);
+	for (i = 0; i < events->len; i++)
+		g_free(g_array_index(events, ProfilingEvent, i).detail);
+	g_array_set_size(events, 0);
+	g_mutex_unlock(&events_mutex);
+}
+
+
+void profiling_finalize(void)
+{
+	recording = FALSE;
+	if (events == NULL)
+		return;
+
+	profiling_clear();
+	g_array_free(events, TRUE);
+	events = NULL;
+}
+
+
+void profiling_set_enabled(gboolean enabled)
+{
+	g_return_if_fail(events != NULL);
+
+	recording = enabled;
+}
+
+
+gboolean profiling_is_enabled(void)
+{
+	return recording;
+}
+
+
+/* Starts a scope at the given monotonic time, e.g. one taken before profiling was enabled. */
+void profiling_scope_begin_at(ProfilingScope *scope, const gchar *category, const gchar *name,
+		gint64 start)
+{
+	scope->category = category;
+	scope->name = name;
+	scope->start = G_LIKELY(! recording) ? 0 : start;
+}
+
+
+void profiling_scope_begin(ProfilingScope *scope, const gchar *category, const gchar *name)
+{
+	scope->category = category;
+	scope->name = name;
+	scope->start = G_LIKELY(! recording) ? 0 : g_get_monotonic_time();
+}
+
+
+/* Records the scope, if it was started while recording.
+ * detail is an optional UTF-8 string, e.g. a filename, shown with the event. */
+void profiling_scope_end(ProfilingScope *scope, const gchar *detail)
+{
+	ProfilingEvent event;
+
+	if (G_LIKELY(scope->start == 0) || ! recording)
+		return;
+
+	event.category = scope->category;
+	event.name = scope->name;
+	event.start = scope->start;
+	event.duration = g_get_monotonic_time() - scope->start;
+	event.thread = g_thread_self();
+	scope->start = 0;
+
+	g_mutex_lock(&events_mutex);
+	if (events->len < PROFILING_MAX_EVENTS)
+	{
+		event.detail = g_strdup(detail);
+		g_array_append_val(events, event);
+	}
+	g_mutex_unlock(&events_mutex);
+}
+
+
+static void append_json_string(GString *str, const gchar *text)
+{
+	const gchar *c;
+
+	g_string_append_c(str, '"');
+	for (c = text; *c; c++)
+	{
+		switch (*c)
+		{
+			case '"': g_string_append(str, "\\\""); break;
+			case '\\': g_string_append(str, "\\\\"); break;
+			case '\n': g_string_append(str, "\\n"); break;
+			case '\t': g_string_append(str, "\\t"); break;
+			default:
+				if ((guchar) *c < 0x20)
+					g_string_append_printf(str, "\\u%04x", (guint) (guchar) *c);
+				else
+					g_string_append_c(str, *c);
+		}
+	}
+	g_string_append_c(str, '"');
+}
+
+
+/* The main thread is tid 1, other threads are numbered in order of appearance. */
+static guint get_thread_id(GHashTable *thread_ids, GThread *thread)
+{
+	guint tid;
+
+	if (thread == main_thread)
+		return 1;
+
+	tid = GPOINTER_TO_UINT(g_hash_table_lookup(thread_ids, thread));
+	if (tid == 0)
+	{
+		tid = g_hash_table_size(thread_ids) + 2;
+		g_hash_table_insert(thread_ids, thread, GUINT_TO_POINTER(tid));
+	}
+	return tid;
+}
+
+
+/* Writes the recorded events as a Chrome trace event JSON file. */
+gboolean profiling_write_trace(const gchar *filename, GError **error)
+{
+	GHashTable *thread_ids;
+	GString *str;
+	gboolean ret;
+	guint i;
+
+	g_return_val_if_fail(filename != NULL, FALSE);
+	g_return_val_if_fail(events != NULL, FALSE);
+
+	thread_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	str = g_string_sized_new(128 + events->len * 128);
+	g_string_append(str, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	g_mutex_lock(&events_mutex);
+	for (i = 0; i < events->len; i++)
+	{
+		ProfilingEvent *event = &g_array_index(events, ProfilingEvent, i);
+
+		g_string_append(str, "{\"name\":");
+		append_json_string(str, event->name);
+		g_string_append(str, ",\"cat\":");
+		append_json_string(str, event->category);
+		g_string_append_printf(str,
+			",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT
+			",\"pid\":1,\"tid\":%u",
+			event->start - origin_time, event->duration,
+			get_thread_id(thread_ids, event->thread));
+		if (event->detail != NULL)
+		{
+			g_string_append(str, ",\"args\":{\"detail\":");
+			append_json_string(str, event->detail);
+			g_string_append_c(str, '}');
+		}
+		g_string_append(str, i + 1 < events->len ? "},\n" : "}\n");
+	}
+	g_mutex_unlock(&events_mutex);
+
+	g_string_append(str, "]}\n");
+	ret = g_file_set_contents(filename, str->str, str->len, error);
+
+	g_string_free(str, TRUE);
+	g_hash_table_destroy(thread_ids);
+	return ret;
+}
+
+
+static gint cmp_events_by_start(gconstpointer a, gconstpointer b)
+{
+	const ProfilingEvent *ea = *(const ProfilingEvent **) a;
+	const ProfilingEvent *eb = *(const ProfilingEvent **) b;
+
+	if (ea->start != eb->start)
+		return ea->start < eb->start ? -1 : 1;
+	/* enclosing scopes first */
+	if (ea->duration != eb->duration)
+		return ea->duration > eb->duration ? -1 : 1;
+	return 0;
+}
+
+
+/* Logs the main thread events of category as an indented tree of timings,
+ * events are recorded when they end so nested scopes need sorting first. */
+void profiling_log_report(const gchar *category)
+{
+	GPtrArray *sorted;
+	GPtrArray *stack;
+	guint i;
+
+	g_return_if_fail(category != NULL);
+	g_return_if_fail(events != NULL);
+
+	sorted = g_ptr_array_new();
+	stack = g_ptr_array_new();
+
+	g_mutex_lock(&events_mutex);
+	for (i = 0; i < events->len; i++)
+	{
+		ProfilingEvent *event = &g_array_index(events, ProfilingEvent, i);
+
+		if (event->thread == main_thread && strcmp(event->category, category) == 0)
+			g_ptr_array_add(sorted, event);
+	}
+	g_ptr_array_sort(sorted, cmp_events_by_start);
+
+	for (i = 0; i < sorted->len; i++)
+	{
+		ProfilingEvent *event = g_ptr_array_index(sorted, i);
+
+		/* drop the enclosing scopes which ended before this one */
+		while (stack->len > 0)
+		{
+			ProfilingEvent *parent = g_ptr_array_index(stack, stack->len - 1);
+
+			if (parent->start + parent->duration > event->start)
+				break;
+			g_ptr_array_remove_index(stack, stack->len - 1);
+		}
+		g_message("%*s%-*s %9.2f ms", (gint) stack->len * 2, "",
+			MAX(32 - (gint) stack->len * 2, 0), event->name, event->duration / 1000.0);
+		g_ptr_array_add(stack, event);
+	}
+	g_mutex_unlock(&events_mutex);
+
+	g_ptr_array_free(stack, TRUE);
+	g_ptr_array_free(sorted, TRUE);
+}
+
+
+/* bucket 0 is below 1 ms, bucket n from 2^(n-1) up to 2^n ms */
+static guint get_histogram_bucket(gint64 duration)
+{
+	gint64 ms = duration / 1000;
+	guint bucket = 0;
+
+	while (ms > 0 && bucket < GEANY_PERF_HISTOGRAM_SIZE - 1)
+	{
+		ms >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+
+static void update_stats(GeanyPerfStats *stats, gint64 duration, gsize bytes)
+{
+	stats->calls++;
+	stats->total_time += duration;
+	stats->max_time = MAX(stats->max_time, duration);
+	stats->bytes += bytes;
+	stats->histogram[get_histogram_bucket(duration)]++;
+}
+
+
+/* Adds a call of counter which started at start (from g_get_monotonic_time()).
+ * doc can be NULL for operations not related to a document. */
+void profiling_counter_add(ProfilingCounter counter, GeanyDocument *doc, gint64 start, gsize bytes)
+{
+	gint64 duration = g_get_monotonic_time() - start;
+
+	g_return_if_fail(counter < PROFILING_N_COUNTERS);
+
+	update_stats(&global_stats[counter], duration, bytes);
+	if (doc != NULL)
+	{
+		if (doc->priv->perf_stats == NULL)
+			doc->priv->perf_stats = g_new0(GeanyPerfStats, PROFILING_N_COUNTERS);
+		update_stats(&doc->priv->perf_stats[counter], duration, bytes);
+	}
+}
+
+
+/** Gets the names of the available performance counters.
+ *
+ * @return @transfer{none} @array{zero-terminated=1} The counter names, e.g. @c "update-tags".
+ *
+ * @since 1.39 (API 245)
+ */
+GEANY_API_SYMBOL
+const gchar * const *profiling_get_counter_names(void)
+{
+	return counter_names;
+}
+
+
+/** Gets the statistics of a performance counter.
+ *
+ * Counters are kept for the whole session and for each document. They are updated
+ * as long as Geany runs, so copy the result to compare it with later values.
+ *
+ * @param name Counter name, see profiling_get_counter_names().
+ * @param doc @nullable Document, or @c NULL for the statistics of all documents.
+ * @return @transfer{none} @nullable The statistics, or @c NULL if there is no such counter.
+ * They must not be modified and are only valid until the document is closed.
+ *
+ * @since 1.39 (API 245)
+ */
+GEANY_API_SYMBOL
+const GeanyPerfStats *profiling_get_stats(const gchar *name, GeanyDocument *doc)
+{
+	guint i;
+
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(doc == NULL || doc->is_valid, NULL);
+
+	for (i = 0; i < PROFILING_N_COUNTERS; i++)
+	{
+		if (strcmp(counter_names[i], name) != 0)
+			continue;
+
+		if (doc == NULL)
+			return &global_stats[i];
+		return doc->priv->perf_stats != NULL ? &doc->priv->perf_stats[i] : &empty_stats;
+	}
+	return NULL;
+}
+
+
+/** Resets the performance counters.
+ *
+ * @param doc @nullable Document, or @c NULL to reset the counters of all documents and
+ * the session.
+ *
+ * @since 1.39 (API 245)
+ */
+GEANY_API_SYMBOL
+void profiling_reset_stats(GeanyDocument *doc)
+{
+	guint i;
+
+	g_return_if_fail(doc == NULL || doc->is_valid);
+
+	if (doc != NULL)
+	{
+		/* keep the memory, pointers returned by profiling_get_stats() stay valid */
+		if (doc->priv->perf_stats != NULL)
+			memset(doc->priv->perf_stats, 0, PROFILING_N_COUNTERS * sizeof(GeanyPerfStats));
+		return;
+	}
+
+	memset(global_stats, 0, sizeof(global_stats));
+	foreach_document(i)
+		profiling_reset_stats(documents[i]);
+}
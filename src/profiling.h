@@ -0,0 +1,116 @@
+/*
+ *      profiling.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2026 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * @file profiling.h
+ * Performance counters of expensive operations.
+ **/
+
+
+#ifndef GEANY_PROFILING_H
+#define GEANY_PROFILING_H 1
+
+#include "document.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/** Number of buckets in GeanyPerfStats::histogram.
+ * @since 1.39 (API 245) */
+#define GEANY_PERF_HISTOGRAM_SIZE 12
+
+/** Statistics about an expensive operation, see profiling_get_stats().
+ * @since 1.39 (API 245) */
+typedef struct GeanyPerfStats
+{
+	guint64	calls;			/**< Number of calls. */
+	gint64	total_time;		/**< Time spent in all calls, in microseconds. */
+	gint64	max_time;		/**< Duration of the slowest call, in microseconds. */
+	guint64	bytes;			/**< Number of bytes processed. */
+	/** Number of calls by duration: bucket 0 counts calls taking less than 1 millisecond,
+	 * bucket @c n those taking 2^(n-1) up to 2^n milliseconds and the last bucket
+	 * all slower calls. */
+	guint64	histogram[GEANY_PERF_HISTOGRAM_SIZE];
+}
+GeanyPerfStats;
+
+
+const gchar * const *profiling_get_counter_names(void);
+
+const GeanyPerfStats *profiling_get_stats(const gchar *name, GeanyDocument *doc);
+
+void profiling_reset_stats(GeanyDocument *doc);
+
+
+#ifdef GEANY_PRIVATE
+
+/* Hot paths with performance counters, see counter_names in profiling.c */
+typedef enum
+{
+	PROFILING_COUNTER_UPDATE_TAGS,
+	PROFILING_COUNTER_UPDATE_TAG_LIST,
+	PROFILING_COUNTER_AUTO_COMPLETE,
+	PROFILING_COUNTER_FIND_TYPENAMES,
+	PROFILING_COUNTER_STYLING,
+	PROFILING_N_COUNTERS
+}
+ProfilingCounter;
+
+/* A timed region, usually a local variable of the function being measured.
+ * Category and name must be static strings. */
+typedef struct ProfilingScope
+{
+	const gchar *category;
+	const gchar *name;
+	gint64 start;	/* monotonic time in microseconds, 0 if not recording */
+}
+ProfilingScope;
+
+
+void profiling_init(void);
+
+void profiling_finalize(void);
+
+void profiling_set_enabled(gboolean enabled);
+
+gboolean profiling_is_enabled(void);
+
+void profiling_clear(void);
+
+void profiling_scope_begin(ProfilingScope *scope, const gchar *category, const gchar *name);
+
+void profiling_scope_begin_at(ProfilingScope *scope, const gchar *category, const gchar *name,
+		gint64 start);
+
+void profiling_scope_end(ProfilingScope *scope, const gchar *detail);
+
+gboolean profiling_write_trace(const gchar *filename, GError **error);
+
+void profiling_log_report(const gchar *category);
+
+void profiling_counter_add(ProfilingCounter counter, GeanyDocument *doc, gint64 start, gsize bytes);
+
+#endif /* GEANY_PRIVATE */
+
+G_END_DECLS
+
+#endif /* GEANY_PROFILING_H */
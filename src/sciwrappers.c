@@ -357,6 +357,21 @@ void sci_empty_undo_buffer(ScintillaObject *sci)
 }
 
 
+/* Returns the size of the text Scintilla keeps for undo and redo. */
+gsize sci_get_undo_memory(ScintillaObject *sci)
+{
+	return (gsize) SSM(sci, SCI_GETUNDOMEMORY, 0, 0);
+}
+
+
+/* Drops the oldest undo steps until at most max_bytes of text are kept.
+ * Returns the number of dropped steps. */
+guint sci_trim_undo_history(ScintillaObject *sci, gsize max_bytes)
+{
+	return (guint) SSM(sci, SCI_TRIMUNDOHISTORY, max_bytes, 0);
+}
+
+
 gboolean sci_is_modified(ScintillaObject *sci)
 {
 	return (SSM(sci, SCI_GETMODIFY, 0, 0) != 0);
@@ -760,6 +775,25 @@ gchar *sci_get_contents(ScintillaObject *sci, gint buffer_len)
 }
 
 
+/* Gets direct pointers to the two halves of Scintilla's gap buffer, i.e. the text before
+ * and after the gap. Unlike SCI_GETCHARACTERPOINTER this never moves the gap, so it is
+ * cheap even right after an edit near the start of a big document.
+ * Either half may be empty, and neither is NUL-terminated.
+ * Warning: the pointers are invalidated by any further modification of the document. */
+void sci_get_text_segments(ScintillaObject *sci, const gchar **first, gint *first_len,
+		const gchar **second, gint *second_len)
+{
+	const gint len = sci_get_length(sci);
+	const gint gap = (gint) SSM(sci, SCI_GETGAPPOSITION, 0, 0);
+
+	/* SCI_GETRANGEPOINTER only rearranges the buffer for ranges spanning the gap */
+	*first = (const gchar *) SSM(sci, SCI_GETRANGEPOINTER, 0, gap);
+	*first_len = gap;
+	*second = (const gchar *) SSM(sci, SCI_GETRANGEPOINTER, (uptr_t) gap, len - gap);
+	*second_len = len - gap;
+}
+
+
 /** Gets selected text.
  * @deprecated sci_get_selected_text is deprecated and should not be used in newly-written code.
  * Use sci_get_selection_contents() instead.
@@ -854,6 +888,20 @@ gboolean sci_get_fold_expanded(ScintillaObject *sci, gint line)
 }
 
 
+void sci_set_fold_expanded(ScintillaObject *sci, gint line, gboolean expanded)
+{
+	SSM(sci, SCI_SETFOLDEXPANDED, (uptr_t) line, expanded);
+}
+
+
+/* Shows or hides the lines from start_line to end_line (inclusive) without changing fold
+ * states or styling anything. */
+void sci_set_lines_visible(ScintillaObject *sci, gint start_line, gint end_line, gboolean visible)
+{
+	SSM(sci, visible ? SCI_SHOWLINES : SCI_HIDELINES, (uptr_t) start_line, end_line);
+}
+
+
 void sci_colourise(ScintillaObject *sci, gint start, gint end)
 {
 	SSM(sci, SCI_COLOURISE, (uptr_t) start, end);
@@ -1064,6 +1112,155 @@ gint sci_get_style_at(ScintillaObject *sci, gint position)
 }
 
 
+/* number of characters fetched per SCI_GETSTYLEDTEXT call */
+#define STYLE_RUN_CHUNK_SIZE (64 * 1024)
+
+struct SciStyleRunIter
+{
+	ScintillaObject *sci;
+	gint pos;			/* document position of the next chunk */
+	gint end;			/* end of the iterated range */
+	gint offset;		/* offset of the next run in the current chunk */
+	gint length;		/* number of characters of the current chunk to iterate */
+	gchar *cells;		/* SCI_GETSTYLEDTEXT buffer of character and style pairs */
+	gchar *text;		/* text of the current chunk, followed by the next character */
+	guchar *styles;		/* styles of the current chunk */
+};
+
+
+/** Creates an iterator over the runs of equally styled text between @a start and @a end.
+ *
+ * Unlike calling sci_get_style_at() and sci_get_char_at() for each position, this
+ * fetches text and styles in large chunks, so it is suitable for walking whole
+ * documents, e.g. to export them. The range is colourised as needed first.
+ *
+ * @param sci Scintilla widget.
+ * @param start Start position.
+ * @param end End position, or @c -1 for the end of the document.
+ * @return @transfer{full} A new iterator. Free it with sci_style_run_iter_free().
+ *
+ * @warning The document must not be modified while the iterator is in use.
+ *
+ * @since 1.39 (API 244)
+ */
+GEANY_API_SYMBOL
+SciStyleRunIter *sci_style_run_iter_new(ScintillaObject *sci, gint start, gint end)
+{
+	SciStyleRunIter *iter;
+	const gint length = sci_get_length(sci);
+
+	g_return_val_if_fail(start >= 0, NULL);
+
+	if (end < 0 || end > length)
+		end = length;
+
+	iter = g_new0(SciStyleRunIter, 1);
+	iter->sci = sci;
+	iter->pos = start;
+	iter->end = end;
+	/* one more character than iterated, so each run can be followed by the next one */
+	iter->cells = g_malloc(2 * (STYLE_RUN_CHUNK_SIZE + 1) + 2);
+	iter->text = g_malloc(STYLE_RUN_CHUNK_SIZE + 2);
+	iter->styles = g_malloc(STYLE_RUN_CHUNK_SIZE + 1);
+	return iter;
+}
+
+
+static gboolean style_run_iter_fill(SciStyleRunIter *iter)
+{
+	struct Sci_TextRange tr;
+	gint doc_length, fetch_end, end_styled, fetched, i;
+
+	if (iter->pos >= iter->end)
+		return FALSE;
+
+	doc_length = sci_get_length(iter->sci);
+	iter->length = MIN(STYLE_RUN_CHUNK_SIZE, iter->end - iter->pos);
+	fetch_end = MIN(iter->pos + iter->length + 1, doc_length);
+
+	end_styled = sci_get_end_styled(iter->sci);
+	if (end_styled < fetch_end)
+	{
+		/* restart at a line start, where the lexer state is well defined */
+		end_styled = sci_get_position_from_line(iter->sci,
+			sci_get_line_from_position(iter->sci, end_styled));
+		sci_colourise(iter->sci, end_styled, fetch_end);
+	}
+
+	tr.chrg.cpMin = iter->pos;
+	tr.chrg.cpMax = fetch_end;
+	tr.lpstrText = iter->cells;
+	SSM(iter->sci, SCI_GETSTYLEDTEXT, 0, (sptr_t) &tr);
+
+	fetched = fetch_end - iter->pos;
+	for (i = 0; i < fetched; i++)
+	{
+		iter->text[i] = iter->cells[2 * i];
+		iter->styles[i] = (guchar) iter->cells[2 * i + 1];
+	}
+	iter->text[fetched] = '\0';
+
+	iter->pos += iter->length;
+	iter->offset = 0;
+	return TRUE;
+}
+
+
+/** Advances @a iter to the next run of equally styled text.
+ *
+ * Runs never span more than an internal chunk size, so two consecutive runs may
+ * have the same style.
+ *
+ * @param iter Iterator.
+ * @param style @out Return location for the style of the run.
+ * @param text @out @transfer{none} Return location for the text of the run. It is
+ * not NUL-terminated but followed by the character after the run, or a NUL at the
+ * end of the document, so @c text[length] can be used for look-ahead. It is only
+ * valid until the next call.
+ * @param length @out Return location for the length of the run in bytes.
+ * @return @c TRUE if there was another run, @c FALSE at the end of the range.
+ *
+ * @since 1.39 (API 244)
+ */
+GEANY_API_SYMBOL
+gboolean sci_style_run_iter_next(SciStyleRunIter *iter, gint *style,
+		const gchar **text, gint *length)
+{
+	gint i, run_style;
+
+	g_return_val_if_fail(iter != NULL, FALSE);
+
+	if (iter->offset >= iter->length && ! style_run_iter_fill(iter))
+		return FALSE;
+
+	run_style = iter->styles[iter->offset];
+	for (i = iter->offset + 1; i < iter->length && iter->styles[i] == run_style; i++);
+
+	*style = run_style;
+	*text = iter->text + iter->offset;
+	*length = i - iter->offset;
+	iter->offset = i;
+	return TRUE;
+}
+
+
+/** Frees an iterator created with sci_style_run_iter_new().
+ * @param iter Iterator.
+ *
+ * @since 1.39 (API 244)
+ */
+GEANY_API_SYMBOL
+void sci_style_run_iter_free(SciStyleRunIter *iter)
+{
+	g_return_if_fail(iter != NULL);
+
+	g_free(iter->cells);
+	g_free(iter->text);
+	g_free(iter->styles);
+	g_free(iter);
+}
+
+
 void sci_set_codepage(ScintillaObject *sci, gint cp)
 {
 	g_return_if_fail(cp == 0 || cp == SC_CP_UTF8);
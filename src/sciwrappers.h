@@ -29,6 +29,11 @@
 
 G_BEGIN_DECLS
 
+/** Opaque iterator over the runs of equally styled text of a document range.
+ * @see sci_style_run_iter_new().
+ * @since 1.39 (API 244) */
+typedef struct SciStyleRunIter SciStyleRunIter;
+
 #ifdef GEANY_PRIVATE
 # ifndef NDEBUG
 #  define SSM(s, m, w, l) sci_send_message_internal(__FILE__, __LINE__, s, m, w, l)
@@ -83,6 +88,10 @@ gint				sci_find_text				(ScintillaObject *sci, gint flags, struct Sci_TextToFin
 void				sci_set_font				(ScintillaObject *sci, gint style, const gchar *font, gint size);
 void				sci_goto_line				(ScintillaObject *sci, gint line, gboolean unfold);
 gint				sci_get_style_at			(ScintillaObject *sci, gint position);
+SciStyleRunIter*	sci_style_run_iter_new		(ScintillaObject *sci, gint start, gint end);
+gboolean			sci_style_run_iter_next		(SciStyleRunIter *iter, gint *style,
+												 const gchar **text, gint *length);
+void				sci_style_run_iter_free		(SciStyleRunIter *iter);
 gchar*				sci_get_contents_range		(ScintillaObject *sci, gint start, gint end);
 void				sci_insert_text				(ScintillaObject *sci, gint pos, const gchar *text);
 
@@ -111,6 +120,8 @@ void				sci_get_text_range			(ScintillaObject *sci, gint start, gint end, gchar
 #ifdef GEANY_PRIVATE
 
 gchar*				sci_get_string				(ScintillaObject *sci, guint msg, gulong wParam);
+void				sci_get_text_segments		(ScintillaObject *sci, const gchar **first, gint *first_len,
+												 const gchar **second, gint *second_len);
 
 void 				sci_set_line_numbers		(ScintillaObject *sci,  gboolean set);
 void				sci_set_mark_long_lines		(ScintillaObject *sci,	gint type, gint column, const gchar *color);
@@ -121,6 +132,8 @@ gboolean			sci_can_undo				(ScintillaObject *sci);
 void 				sci_undo					(ScintillaObject *sci);
 void 				sci_redo					(ScintillaObject *sci);
 void 				sci_empty_undo_buffer		(ScintillaObject *sci);
+gsize				sci_get_undo_memory			(ScintillaObject *sci);
+guint				sci_trim_undo_history		(ScintillaObject *sci, gsize max_bytes);
 gboolean			sci_is_modified				(ScintillaObject *sci);
 
 void				sci_set_visible_eols		(ScintillaObject *sci, gboolean set);
@@ -159,6 +172,9 @@ gint				sci_get_fold_parent			(ScintillaObject *sci, gint start_line);
 
 void 				sci_set_folding_margin_visible (ScintillaObject *sci, gboolean set);
 gboolean			sci_get_fold_expanded		(ScintillaObject *sci, gint line);
+void				sci_set_fold_expanded		(ScintillaObject *sci, gint line, gboolean expanded);
+void				sci_set_lines_visible		(ScintillaObject *sci, gint start_line, gint end_line,
+													 gboolean visible);
 
 void				sci_colourise				(ScintillaObject *sci, gint start, gint end);
 void				sci_clear_all				(ScintillaObject *sci);
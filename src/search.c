@@ -1702,9 +1702,9 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const
 
 	/* we can pass 'enc' without strdup'ing it here because it's a global const string and
 	 * always exits longer than the lifetime of this function */
-	if (spawn_with_callbacks(dir, command_line, argv, NULL, 0, NULL, NULL, search_read_io,
-		(gpointer) enc, 0, search_read_io_stderr, (gpointer) enc, 0, search_finished, NULL,
-		NULL, &error))
+	if (spawn_with_callbacks(dir, command_line, argv, NULL, SPAWN_LINES_BATCHED, NULL, NULL,
+		search_read_io, (gpointer) enc, 0, search_read_io_stderr, (gpointer) enc, 0,
+		search_finished, NULL, NULL, &error))
  	{
 		gchar *utf8_str;
 
@@ -1834,15 +1834,30 @@ static void read_fif_io(gchar *msg, GIOCondition condition, gchar *enc, gint msg
 }
 
 
+/* the lines are batched, each one followed by a nul */
+static void read_fif_io_lines(GString *string, GIOCondition condition, gchar *enc, gint msg_color)
+{
+	gchar *line = string->str;
+
+	while (line < string->str + string->len)
+	{
+		gchar *next = line + strlen(line) + 1;
+
+		read_fif_io(line, condition, enc, msg_color);
+		line = next;
+	}
+}
+
+
 static void search_read_io(GString *string, GIOCondition condition, gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_BLACK);
+	read_fif_io_lines(string, condition, data, COLOR_BLACK);
 }
 
 
 static void search_read_io_stderr(GString *string, GIOCondition condition, gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_DARK_RED);
+	read_fif_io_lines(string, condition, data, COLOR_DARK_RED);
 }
 
 
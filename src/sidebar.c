@@ -34,7 +34,9 @@
 #include "filetypesprivate.h"
 #include "geanyobject.h"
 #include "keyfile.h"
+#include "main.h"
 #include "navqueue.h"
+#include "profiling.h"
 #include "stash.h"
 #include "support.h"
 #include "symbols.h"
@@ -197,6 +199,10 @@ void sidebar_update_tag_list(GeanyDocument *doc, gboolean update)
 	if (gtk_notebook_get_current_page(GTK_NOTEBOOK(main_widgets.sidebar_notebook)) != TREEVIEW_SYMBOL)
 		return; /* don't bother updating symbol tree if we don't see it */
 
+	/* while opening many documents only the current one's tree will be seen */
+	if (main_status.opening_batch && doc != document_get_current())
+		return;
+
 	/* changes the tree view to the given one, trying not to do useless changes */
 	#define CHANGE_TREE(new_child) \
 		G_STMT_START { \
@@ -223,6 +229,8 @@ void sidebar_update_tag_list(GeanyDocument *doc, gboolean update)
 
 	if (doc->priv->tag_tree_dirty)
 	{	/* updating the tag list in the left tag window */
+		gint64 start = g_get_monotonic_time();
+
 		if (doc->priv->tag_tree == NULL)
 		{
 			doc->priv->tag_store = gtk_tree_store_new(
@@ -235,6 +243,7 @@ void sidebar_update_tag_list(GeanyDocument *doc, gboolean update)
 
 		doc->has_tags = symbols_recreate_tag_list(doc, SYMBOLS_SORT_USE_PREVIOUS);
 		doc->priv->tag_tree_dirty = FALSE;
+		profiling_counter_add(PROFILING_COUNTER_UPDATE_TAG_LIST, doc, start, 0);
 	}
 
 	if (doc->has_tags)
@@ -493,6 +502,22 @@ void sidebar_openfiles_add(GeanyDocument *doc)
 }
 
 
+/* Keeping the store sorted while adding many documents gets quadratic, so
+ * sort it only once they are all added, see document_begin_batch_open(). */
+void sidebar_openfiles_begin_batch(void)
+{
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store_openfiles),
+		GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+}
+
+
+void sidebar_openfiles_end_batch(void)
+{
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(store_openfiles),
+		DOCUMENTS_SHORTNAME, GTK_SORT_ASCENDING);
+}
+
+
 static void openfiles_remove(GeanyDocument *doc)
 {
 	GtkTreeIter *iter = &doc->priv->iter;
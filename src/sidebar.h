@@ -60,6 +60,10 @@ void sidebar_openfiles_update(GeanyDocument *doc);
 
 void sidebar_openfiles_update_all(void);
 
+void sidebar_openfiles_begin_batch(void);
+
+void sidebar_openfiles_end_batch(void);
+
 void sidebar_select_openfiles_item(GeanyDocument *doc);
 
 void sidebar_remove_document(GeanyDocument *doc);
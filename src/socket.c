@@ -64,6 +64,7 @@
 #include "encodings.h"
 #include "main.h"
 #include "support.h"
+#include "ui_utils.h"
 #include "utils.h"
 #include "win32.h"
 
@@ -616,7 +617,7 @@ static void socket_init_win32(void)
 #endif
 
 
-static void handle_input_filename(const gchar *buf)
+static gchar *get_input_locale_filename(const gchar *buf)
 {
 	gchar *utf8_filename, *locale_filename;
 
@@ -627,18 +628,41 @@ static void handle_input_filename(const gchar *buf)
 		utf8_filename = g_strdup(buf);
 
 	locale_filename = utils_get_locale_from_utf8(utf8_filename);
-	if (locale_filename)
+	g_free(utf8_filename);
+	return locale_filename;
+}
+
+
+/* opens all the files at once, so that e.g. "geany *.c" doesn't update the UI for each */
+static void handle_input_filenames(GPtrArray *locale_filenames)
+{
+	gboolean batch = FALSE;
+	guint i;
+
+	g_ptr_array_add(locale_filenames, NULL);
+	for (i = 0; i + 1 < locale_filenames->len; i++)
 	{
+		const gchar *locale_filename = g_ptr_array_index(locale_filenames, i);
+
 		if (g_str_has_suffix(locale_filename, ".geany"))
 		{
+			/* the project's session is opened as usual */
+			if (batch)
+				document_end_batch_open();
+			batch = FALSE;
 			if (project_ask_close())
 				main_load_project_from_command_line(locale_filename, TRUE);
 		}
 		else
+		{
+			if (! batch)
+				document_begin_batch_open((const gchar * const *) locale_filenames->pdata + i);
+			batch = TRUE;
 			main_handle_filename(locale_filename);
+		}
 	}
-	g_free(utf8_filename);
-	g_free(locale_filename);
+	if (batch)
+		document_end_batch_open();
 }
 
 
@@ -658,6 +682,26 @@ static gchar *build_document_list(void)
 }
 
 
+/* Stops or resumes handling commands from other instances. Meanwhile, their connections
+ * wait in the socket's backlog. */
+void socket_set_input_blocked(gboolean blocked)
+{
+	if (socket_info.read_ioc == NULL)
+		return;
+
+	if (blocked && socket_info.lock_socket_tag > 0)
+	{
+		g_source_remove(socket_info.lock_socket_tag);
+		socket_info.lock_socket_tag = 0;
+	}
+	else if (! blocked && socket_info.lock_socket_tag == 0)
+	{
+		socket_info.lock_socket_tag = g_io_add_watch(socket_info.read_ioc,
+			G_IO_IN | G_IO_PRI | G_IO_ERR, socket_lock_input_cb, main_widgets.window);
+	}
+}
+
+
 gboolean socket_lock_input_cb(GIOChannel *source, GIOCondition condition, gpointer data)
 {
 	gint fd, sock;
@@ -679,17 +723,24 @@ gboolean socket_lock_input_cb(GIOChannel *source, GIOCondition condition, gpoint
 		g_free(command);
 		if (strncmp(buf, "open", 4) == 0)
 		{
+			GPtrArray *filenames = g_ptr_array_new_with_free_func(g_free);
+
 			cl_options.readonly = strncmp(buf+4, "ro", 2) == 0; /* open in readonly? */
 			while (socket_fd_gets(sock, buf, sizeof(buf)) != -1 && *buf != '.')
 			{
 				gsize buf_len = strlen(buf);
+				gchar *locale_filename;
 
 				/* remove trailing newline */
 				if (buf_len > 0 && buf[buf_len - 1] == '\n')
 					buf[buf_len - 1] = '\0';
 
-				handle_input_filename(buf);
+				locale_filename = get_input_locale_filename(buf);
+				if (locale_filename)
+					g_ptr_array_add(filenames, locale_filename);
 			}
+			handle_input_filenames(filenames);
+			g_ptr_array_free(filenames, TRUE);
 			popup = TRUE;
 		}
 		else if (strncmp(buf, "doclist", 7) == 0)
@@ -48,6 +48,8 @@ gboolean socket_lock_input_cb(GIOChannel *source, GIOCondition condition, gpoint
 
 gint socket_finalize(void);
 
+void socket_set_input_blocked(gboolean blocked);
+
 G_END_DECLS
 
 #endif /* GEANY_SOCKET_H */
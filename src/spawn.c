@@ -843,6 +843,7 @@ typedef struct _SpawnChannelData
 	/* stdout/stderr only */
 	GString *buffer;       /* NULL if recursive */
 	GString *line_buffer;  /* NULL if char buffered */
+	gboolean batch_lines;  /* pass all complete lines at once */
 	gsize max_length;
 	/* stdout/stderr: fix continuous empty G_IO_IN-s for recursive channels */
 	guint empty_gio_ins;
@@ -934,32 +935,61 @@ static gboolean spawn_read_cb(GIOChannel *channel, GIOCondition condition, gpoin
 			while ((status = g_io_channel_read_chars(channel, line_buffer->str + n,
 				DEFAULT_IO_LENGTH, &chars_read, NULL)) == G_IO_STATUS_NORMAL)
 			{
+				/* start of the first line not passed to the callback yet */
+				gsize line_start = 0;
+
 				g_string_set_size(line_buffer, n + chars_read);
 
 				while (n < line_buffer->len)
 				{
-					gsize line_len = 0;
+					gsize line_end = 0;
+					gchar c = line_buffer->str[n];
 
-					if (n == sc->max_length)
-						line_len = n;
-					else if (strchr("\n", line_buffer->str[n]))  /* '\n' or '\0' */
-						line_len = n + 1;
-					else if (n < line_buffer->len - 1 && line_buffer->str[n] == '\r')
-						line_len = n + 1 + (line_buffer->str[n + 1] == '\n');
+					if (n - line_start == sc->max_length)
+						line_end = n;
+					else if (c == '\n' || c == '\0')
+						line_end = n + 1;
+					else if (c == '\r' && n < line_buffer->len - 1)
+						line_end = n + 1 + (line_buffer->str[n + 1] == '\n');
 
-					if (!line_len)
+					if (!line_end)
 						n++;
 					else
 					{
-						g_string_append_len(buffer, line_buffer->str, line_len);
-						g_string_erase(line_buffer, 0, line_len);
-						/* input only, failures are reported separately below */
-						sc->cb.read(buffer, input_cond, sc->cb_data);
-						g_string_truncate(buffer, 0);
-						n = 0;
+						g_string_append_len(buffer, line_buffer->str + line_start,
+							line_end - line_start);
+						if (!sc->buffer)
+						{
+							/* a recursive callback may read more data meanwhile, so
+							   don't leave any already passed lines in the buffer */
+							g_string_erase(line_buffer, 0, line_end);
+							line_end = 0;
+						}
+						line_start = n = line_end;
+
+						if (sc->batch_lines)
+						{
+							if (buffer->str[buffer->len - 1] != '\0')
+								g_string_append_c(buffer, '\0');
+						}
+						else
+						{
+							/* input only, failures are reported separately below */
+							sc->cb.read(buffer, input_cond, sc->cb_data);
+							g_string_truncate(buffer, 0);
+						}
 					}
 				}
 
+				if (buffer->len)
+				{
+					sc->cb.read(buffer, input_cond, sc->cb_data);
+					g_string_truncate(buffer, 0);
+				}
+				/* remove all the passed lines at once rather than one by one */
+				g_string_erase(line_buffer, 0, line_start);
+				n -= line_start;
+
 				if (SPAWN_CHANNEL_GIO_WATCH(sc) && !failure_cond)
 					break;
 			}
@@ -1110,6 +1140,9 @@ static void spawn_watch_cb(GPid pid, gint status, gpointer data)
  *  The synchronous execution may not be combined with recursive callbacks.
  *
  *  In line buffered mode, the child input is broken on `\n`, `\r\n`, `\r`, `\0` and max length.
+ *  With @c SPAWN_LINES_BATCHED, all the lines broken from one read are passed together,
+ *  which is much cheaper for children writing many short lines; the max length then
+ *  applies to each line rather than to the whole string.
  *
  *  All I/O callbacks are guaranteed to be invoked at least once with @c G_IO_ERR, @c G_IO_HUP
  *  or @c G_IO_NVAL set (except for a @a stdin_cb which returns @c FALSE before that). For the
@@ -1232,6 +1265,7 @@ gboolean spawn_with_callbacks(const gchar *working_directory, const gchar *comma
 				{
 					sc->line_buffer = g_string_sized_new(sc->max_length +
 						DEFAULT_IO_LENGTH);
+					sc->batch_lines = (spawn_flags & SPAWN_LINES_BATCHED) != 0;
 				}
 
 				sc->empty_gio_ins = 0;
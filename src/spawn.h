@@ -59,7 +59,10 @@ typedef enum
 	SPAWN_STDIN_RECURSIVE      = 0x08,  /**< The stdin callback is recursive. */
 	SPAWN_STDOUT_RECURSIVE     = 0x10,  /**< The stdout callback is recursive. */
 	SPAWN_STDERR_RECURSIVE     = 0x20,  /**< The stderr callback is recursive. */
-	SPAWN_RECURSIVE            = 0x38   /**< All callbacks are recursive. */
+	SPAWN_RECURSIVE            = 0x38,  /**< All callbacks are recursive. */
+	/** Line buffered stdout/stderr callbacks receive all the complete lines read at once.
+	 * @since 1.39 (API 243) */
+	SPAWN_LINES_BATCHED        = 0x40
 } SpawnFlags;
 
 /**
@@ -67,7 +70,9 @@ typedef enum
  *  callback.
  *
  *  In unbuffered mode, the @a string may contain nuls, while in line buffered mode, it may
- *  contain only a single nul as a line termination character at @a string->len - 1. In all
+ *  contain only a single nul as a line termination character at @a string->len - 1. With
+ *  @c SPAWN_LINES_BATCHED, the @a string contains one or more lines, each followed by a nul
+ *  which is part of the data, so they can be walked as consecutive C strings. In all
  *  cases, the @a string will be terminated with a nul character that is not part of the data
  *  at @a string->len.
  *
@@ -46,6 +46,7 @@
 #include "highlighting.h"
 #include "main.h"
 #include "navqueue.h"
+#include "profiling.h"
 #include "sciwrappers.h"
 #include "sidebar.h"
 #include "support.h"
@@ -120,6 +121,37 @@ static void load_user_tags(GeanyFiletypeID ft_id);
 /* get the tags_ignore list, exported by geany_lcpp.c */
 extern gchar **c_tags_ignore;
 
+/* Enables the tag cache if wanted, keyed to invalidate it when the parsers may
+ * produce different tags, i.e. for another Geany version or C ignore list. The
+ * ignore list is checked here rather than when it is loaded for the first C
+ * file, so that all cache lookups use the same key. */
+static void set_tag_cache_dir(void)
+{
+	gchar *path, *dir, *content, *key;
+
+	if (!file_prefs.use_tag_cache)
+		return;
+
+	path = g_build_filename(app->configdir, "ignore.tags", NULL);
+	if (g_file_get_contents(path, &content, NULL, NULL))
+	{
+		gchar *checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5, content, -1);
+
+		key = g_strconcat("version=", VERSION, " ignore=", checksum, NULL);
+		g_free(checksum);
+		g_free(content);
+	}
+	else
+		key = g_strconcat("version=", VERSION, NULL);
+
+	dir = g_build_filename(app->configdir, "tagcache", NULL);
+	tm_workspace_set_tag_cache_dir(dir, key);
+	g_free(dir);
+	g_free(key);
+	g_free(path);
+}
+
+
 /* ignore certain tokens when parsing C-like syntax.
  * Also works for reloading. */
 static void load_c_ignore_tags(void)
@@ -154,6 +186,7 @@ static void load_c_ignore_tags(void)
 void symbols_reload_config_files(void)
 {
 	load_c_ignore_tags();
+	set_tag_cache_dir();
 }
 
 
@@ -222,6 +255,7 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global)
 	GString *s = NULL;
 	GPtrArray *typedefs;
 	TMParserType tag_lang;
+	gint64 start = g_get_monotonic_time();
 
 	if (global)
 		typedefs = app->tm_workspace->global_typename_array;
@@ -248,6 +282,7 @@ GString *symbols_find_typenames_as_string(TMParserType lang, gboolean global)
 			}
 		}
 	}
+	profiling_counter_add(PROFILING_COUNTER_FIND_TYPENAMES, NULL, start, s ? s->len : 0);
 	return s;
 }
 
@@ -2247,6 +2282,9 @@ static gboolean goto_tag(const gchar *name, gboolean definition)
 
 gboolean symbols_goto_tag(const gchar *name, gboolean definition)
 {
+	/* the symbol may be in a restored session file not parsed yet */
+	document_finish_deferred_loads();
+
 	if (goto_tag(name, definition))
 		return TRUE;
 
@@ -2733,6 +2771,8 @@ void symbols_init(void)
 
 	g_signal_connect(geany_object, "document-save", G_CALLBACK(on_document_save), NULL);
 
+	set_tag_cache_dir();
+
 	for (i = 0; i < G_N_ELEMENTS(symbols_icons); i++)
 		symbols_icons[i].pixbuf = get_tag_icon(symbols_icons[i].icon_name);
 }
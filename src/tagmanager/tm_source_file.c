@@ -562,6 +562,146 @@ gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_
 }
 
 
+/* Replaces the tags of the source file by the ones stored in a tags cache file
+ written by tm_source_file_write_tags_cache(). The cache is only used when it
+ was written for the same @a key.
+ @param source_file The source file whose tags should be loaded.
+ @param cache_file The tags cache file.
+ @param key Key describing the parsed file.
+ @return TRUE if the tags were loaded from the cache, FALSE otherwise in which
+ case the tags of the source file are left untouched.
+*/
+gboolean tm_source_file_read_tags_cache(TMSourceFile *source_file, const gchar *cache_file,
+	const gchar *key)
+{
+	gchar buf[BUFSIZ];
+	FILE *fp;
+	TMTag *tag;
+	gboolean hit;
+
+	g_return_val_if_fail(source_file && cache_file && key, FALSE);
+
+	if (NULL == (fp = g_fopen(cache_file, "r")))
+		return FALSE;
+
+	hit = NULL != fgets(buf, BUFSIZ, fp) && strcmp(buf, "# format=tagmanager\n") == 0;
+	hit = hit && NULL != fgets(buf, BUFSIZ, fp) && strncmp(buf, "# key=", 6) == 0 &&
+		strcmp(g_strchomp(buf + 6), key) == 0;
+	if (!hit)
+	{
+		fclose(fp);
+		return FALSE;
+	}
+
+	tm_tags_array_free(source_file->tags_array, FALSE);
+	while (NULL != (tag = new_tag_from_tags_file(source_file, fp, source_file->lang,
+		TM_FILE_FORMAT_TAGMANAGER)))
+		g_ptr_array_add(source_file->tags_array, tag);
+	fclose(fp);
+
+	/* keep the cache entry from being pruned as unused */
+	g_utime(cache_file, NULL);
+
+	return TRUE;
+}
+
+
+/* Checks a string can be stored in a tagmanager tags file and read back unchanged. */
+static gboolean is_cacheable_string(const gchar *str)
+{
+	const guchar *p;
+
+	if (str == NULL)
+		return TRUE;
+	for (p = (const guchar *) str; *p; p++)
+	{
+		if (*p >= TA_NAME || *p == '\n')
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+static gboolean is_cacheable_tag(const TMTag *tag)
+{
+	gsize len;
+
+	/* init_tag_from_file() rejects names not starting with a printable character */
+	if (tag->name == NULL || !isprint((guchar) tag->name[0]))
+		return FALSE;
+	if (!is_cacheable_string(tag->name) || !is_cacheable_string(tag->arglist) ||
+		!is_cacheable_string(tag->scope) || !is_cacheable_string(tag->inheritance) ||
+		!is_cacheable_string(tag->var_type))
+		return FALSE;
+
+	/* the whole line must fit the fgets() buffer of init_tag_from_file() */
+	len = strlen(tag->name) + 64;
+	len += tag->arglist ? strlen(tag->arglist) : 0;
+	len += tag->scope ? strlen(tag->scope) : 0;
+	len += tag->inheritance ? strlen(tag->inheritance) : 0;
+	len += tag->var_type ? strlen(tag->var_type) : 0;
+	return len < BUFSIZ;
+}
+
+
+/* Writes the tags of a source file to a tags cache file, storing all the
+ attributes needed to restore them with tm_source_file_read_tags_cache().
+ The file is replaced atomically. Nothing is written if some of the tags
+ cannot be represented in the tagmanager format. Only reads the tags so it can
+ be called from another thread while holding references to them.
+ @param tags_array The tags of the source file.
+ @param cache_file The tags cache file.
+ @param key Key describing the parsed file, without newlines.
+ @return TRUE on success, FALSE on failure.
+*/
+gboolean tm_source_file_write_tags_cache(GPtrArray *tags_array, const gchar *cache_file,
+	const gchar *key)
+{
+	GString *str;
+	gboolean ret;
+	guint i;
+
+	g_return_val_if_fail(tags_array && cache_file && key, FALSE);
+
+	str = g_string_sized_new(64 * (tags_array->len + 1));
+	g_string_append_printf(str, "# format=tagmanager\n# key=%s\n", key);
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = TM_TAG(tags_array->pdata[i]);
+
+		if (!is_cacheable_tag(tag))
+		{
+			g_string_free(str, TRUE);
+			return FALSE;
+		}
+
+		g_string_append(str, tag->name);
+		g_string_append_printf(str, "%c%d", TA_TYPE, tag->type);
+		if (tag->arglist)
+			g_string_append_printf(str, "%c%s", TA_ARGLIST, tag->arglist);
+		g_string_append_printf(str, "%c%lu", TA_LINE, tag->line);
+		g_string_append_printf(str, "%c%d", TA_LOCAL, tag->local);
+		if (tag->scope)
+			g_string_append_printf(str, "%c%s", TA_SCOPE, tag->scope);
+		if (tag->inheritance)
+			g_string_append_printf(str, "%c%s", TA_INHERITS, tag->inheritance);
+		g_string_append_printf(str, "%c%u", TA_POINTER, tag->pointerOrder);
+		if (tag->var_type)
+			g_string_append_printf(str, "%c%s", TA_VARTYPE, tag->var_type);
+		if (tag->access != TAG_ACCESS_UNKNOWN)
+			g_string_append_printf(str, "%c%c", TA_ACCESS, tag->access);
+		if (tag->impl != TAG_IMPL_UNKNOWN)
+			g_string_append_printf(str, "%c%c", TA_IMPL, tag->impl);
+		g_string_append_c(str, '\n');
+	}
+
+	ret = g_file_set_contents(cache_file, str->str, str->len, NULL);
+	g_string_free(str, TRUE);
+
+	return ret;
+}
+
+
 /* Initializes a TMSourceFile structure from a file name. */
 static gboolean tm_source_file_init(TMSourceFile *source_file, const char *file_name,
 	const char* name)
@@ -62,6 +62,12 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array);
 
+gboolean tm_source_file_read_tags_cache(TMSourceFile *source_file, const gchar *cache_file,
+	const gchar *key);
+
+gboolean tm_source_file_write_tags_cache(GPtrArray *tags_array, const gchar *cache_file,
+	const gchar *key);
+
 gchar tm_source_file_get_tag_impl(const gchar *impl);
 
 gchar tm_source_file_get_tag_access(const gchar *access);
@@ -218,6 +218,40 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 	return returnval;
 }
 
+typedef struct
+{
+	guint64 name_prefix;
+	TMTag *tag;
+} TMSortKey;
+
+/* Packs the first bytes of the tag name so that comparing two prefixes
+ * gives the same result as strcmp() on the beginning of the names. */
+static guint64 get_name_prefix(const TMTag *tag)
+{
+	const guchar *name = (const guchar *) FALLBACK(tag->name, "");
+	guint64 prefix = 0;
+	guint i;
+
+	for (i = 0; i < sizeof(prefix); i++)
+	{
+		prefix <<= 8;
+		if (*name)
+			prefix |= *name++;
+	}
+	return prefix;
+}
+
+/* Sort keys are only used for sort attributes starting with the name. */
+static gint tm_sort_key_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user_data)
+{
+	const TMSortKey *k1 = ptr1;
+	const TMSortKey *k2 = ptr2;
+
+	if (k1->name_prefix != k2->name_prefix)
+		return k1->name_prefix < k2->name_prefix ? -1 : 1;
+	return tm_tag_compare(&k1->tag, &k2->tag, user_data);
+}
+
 gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
 {
 	if (a == b)
@@ -298,14 +332,47 @@ void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates)
 {
 	TMSortOptions sort_options;
+	TMSortKey *keys;
+	guint i, count;
 
 	g_return_if_fail(tags_array);
 
 	sort_options.sort_attrs = sort_attributes;
 	sort_options.partial = FALSE;
-	g_ptr_array_sort_with_data(tags_array, tm_tag_compare, &sort_options);
-	if (dedup)
-		tm_tags_dedup(tags_array, sort_attributes, unref_duplicates);
+
+	if (tags_array->len < 2 || (sort_attributes && sort_attributes[0] != tm_tag_attr_name_t))
+	{
+		g_ptr_array_sort_with_data(tags_array, tm_tag_compare, &sort_options);
+		if (dedup)
+			tm_tags_dedup(tags_array, sort_attributes, unref_duplicates);
+		return;
+	}
+
+	/* names come first so most comparisons are decided by the name prefixes
+	 * without touching the tags at all */
+	keys = g_new(TMSortKey, tags_array->len);
+	for (i = 0; i < tags_array->len; i++)
+	{
+		keys[i].tag = tags_array->pdata[i];
+		keys[i].name_prefix = get_name_prefix(keys[i].tag);
+	}
+	g_qsort_with_data(keys, tags_array->len, sizeof(TMSortKey), tm_sort_key_compare,
+		&sort_options);
+
+	/* like tm_tags_dedup(), keep the last of the equal tags */
+	for (i = 0, count = 0; i < tags_array->len; i++)
+	{
+		if (dedup && count > 0 && keys[i].name_prefix == keys[i - 1].name_prefix &&
+			0 == tm_tag_compare(&keys[i - 1].tag, &keys[i].tag, &sort_options))
+		{
+			if (unref_duplicates)
+				tm_tag_unref(keys[i - 1].tag);
+			count--;
+		}
+		tags_array->pdata[count++] = keys[i].tag;
+	}
+	tags_array->len = count;
+	g_free(keys);
 }
 
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array)
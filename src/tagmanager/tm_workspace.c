@@ -64,8 +64,29 @@ static TMTagType TM_GLOBAL_TYPE_MASK =
 	tm_tag_class_t | tm_tag_enum_t | tm_tag_interface_t |
 	tm_tag_struct_t | tm_tag_typedef_t | tm_tag_union_t | tm_tag_namespace_t;
 
+/* cache entries not used for this long are removed */
+#define TAG_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
 static TMWorkspace *theWorkspace = NULL;
 
+static gchar *tag_cache_dir = NULL;
+static gchar *tag_cache_key = NULL;
+static gboolean tag_cache_pruned = FALSE;
+static GThreadPool *tag_cache_pool = NULL;
+
+/* tags of a source file to be written to the tag cache in the background */
+typedef struct
+{
+	gchar *cache_file;
+	gchar *key;
+	GPtrArray *tags;
+} TagCacheEntry;
+
+/* while batch_update_depth > 0, the tags of updated source files are only
+ * merged into the workspace by tm_workspace_end_batch_update() */
+static guint batch_update_depth = 0;
+static GHashTable *batch_source_files = NULL;
+
 
 static gboolean tm_create_workspace(void)
 {
@@ -104,6 +125,13 @@ void tm_workspace_free(void)
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
 	g_free(theWorkspace);
 	theWorkspace = NULL;
+
+	tm_workspace_set_tag_cache_dir(NULL, NULL);
+
+	if (batch_source_files)
+		g_hash_table_destroy(batch_source_files);
+	batch_source_files = NULL;
+	batch_update_depth = 0;
 }
 
 
@@ -140,8 +168,176 @@ static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag
 }
 
 
+/* Removes cache entries which haven't been used for TAG_CACHE_MAX_AGE. Runs in
+ * its own thread and frees dir. */
+static gpointer prune_tag_cache(gpointer dir)
+{
+	GDir *gdir = g_dir_open(dir, 0, NULL);
+	const gchar *name;
+	gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+
+	while (gdir && (name = g_dir_read_name(gdir)) != NULL)
+	{
+		gchar *path;
+		GStatBuf s;
+
+		if (!g_str_has_suffix(name, ".tags"))
+			continue;
+
+		path = g_build_filename(dir, name, NULL);
+		if (g_stat(path, &s) == 0 && now - (gint64) s.st_mtime > TAG_CACHE_MAX_AGE)
+			g_unlink(path);
+		g_free(path);
+	}
+	if (gdir)
+		g_dir_close(gdir);
+	g_free(dir);
+	return NULL;
+}
+
+
+static void write_tag_cache_entry(gpointer data, gpointer user_data)
+{
+	TagCacheEntry *entry = data;
+
+	tm_source_file_write_tags_cache(entry->tags, entry->cache_file, entry->key);
+
+	tm_tags_array_free(entry->tags, TRUE);
+	g_free(entry->cache_file);
+	g_free(entry->key);
+	g_slice_free(TagCacheEntry, entry);
+}
+
+
+/* Enables the on-disk tag cache used when source files are parsed for the first
+ time (see tm_workspace_add_source_file() and
+ tm_workspace_update_source_file_buffer_cached()). Cached tags are only reused
+ when they were stored with the same key, so it should change whenever the
+ parsers may produce different tags, e.g. for a new application version.
+ Old entries are pruned in the background the first time the cache is enabled.
+ @param dir The cache directory, created if needed. NULL disables the cache and
+ waits for the pending cache writes.
+ @param key Key identifying the parser configuration; it must not contain newlines.
+*/
+void tm_workspace_set_tag_cache_dir(const gchar *dir, const gchar *key)
+{
+	g_free(tag_cache_dir);
+	g_free(tag_cache_key);
+	tag_cache_dir = NULL;
+	tag_cache_key = NULL;
+
+	if (dir == NULL)
+	{
+		if (tag_cache_pool)
+			g_thread_pool_free(tag_cache_pool, FALSE, TRUE);
+		tag_cache_pool = NULL;
+		return;
+	}
+	if (g_mkdir_with_parents(dir, 0700) != 0)
+	{
+		g_warning("Unable to create tag cache directory %s", dir);
+		return;
+	}
+
+	tag_cache_dir = g_strdup(dir);
+	tag_cache_key = g_strdup(key ? key : "");
+	if (!tag_cache_pruned)
+	{
+		g_thread_unref(g_thread_new("tag-cache-prune", prune_tag_cache, g_strdup(dir)));
+		tag_cache_pruned = TRUE;
+	}
+}
+
+
+static gchar *get_tag_cache_file(TMSourceFile *source_file)
+{
+	gchar *checksum = g_compute_checksum_for_string(G_CHECKSUM_MD5, source_file->file_name, -1);
+	gchar *name = g_strconcat(checksum, ".tags", NULL);
+	gchar *path = g_build_filename(tag_cache_dir, name, NULL);
+
+	g_free(name);
+	g_free(checksum);
+	return path;
+}
+
+
+/* identifies the file on disk without reading it and, for a buffer, how it was
+ * read from the file */
+static gchar *get_tag_cache_key(TMSourceFile *source_file, gboolean use_buffer,
+	gsize buf_size, const gchar *buffer_key)
+{
+	GStatBuf s;
+	gchar *key, *buffer_part = NULL;
+
+	if (g_stat(source_file->file_name, &s) != 0)
+		return NULL;
+
+	if (use_buffer)
+		buffer_part = g_strdup_printf(" buffer=%" G_GSIZE_FORMAT " %s", buf_size, buffer_key);
+	key = g_strdup_printf("%s lang=%s size=%" G_GINT64_FORMAT " mtime=%" G_GINT64_FORMAT "%s",
+		tag_cache_key, tm_ctags_get_lang_name(source_file->lang),
+		(gint64) s.st_size, (gint64) s.st_mtime, buffer_part ? buffer_part : "");
+	g_free(buffer_part);
+	return key;
+}
+
+
+/* Queues the tags of the source file to be written to the tag cache by a worker
+ * thread, which takes over cache_file and key. */
+static void queue_tag_cache_write(TMSourceFile *source_file, gchar *cache_file, gchar *key)
+{
+	TagCacheEntry *entry = g_slice_new(TagCacheEntry);
+	guint i;
+
+	entry->cache_file = cache_file;
+	entry->key = key;
+	entry->tags = g_ptr_array_sized_new(source_file->tags_array->len);
+	for (i = 0; i < source_file->tags_array->len; i++)
+		g_ptr_array_add(entry->tags, tm_tag_ref(source_file->tags_array->pdata[i]));
+
+	if (!tag_cache_pool)
+		tag_cache_pool = g_thread_pool_new(write_tag_cache_entry, NULL, 1, FALSE, NULL);
+	g_thread_pool_push(tag_cache_pool, entry, NULL);
+}
+
+
+/* Like tm_source_file_parse() but first tries to load the tags from the tag
+ * cache, and stores the parsed tags in it in the background on a cache miss.
+ * Entries are looked up by the size and mtime of the file on disk so nothing
+ * needs to be read or hashed. A buffer is only looked up if buffer_key tells
+ * how it was read from the unchanged file, e.g. with which encoding. */
+static void parse_source_file_cached(TMSourceFile *source_file, guchar *text_buf,
+	gsize buf_size, gboolean use_buffer, const gchar *buffer_key)
+{
+	gchar *cache_file, *key = NULL;
+
+	if (tag_cache_dir != NULL && source_file->file_name != NULL &&
+		source_file->lang != TM_PARSER_NONE && (!use_buffer || buffer_key != NULL))
+		key = get_tag_cache_key(source_file, use_buffer, buf_size, buffer_key);
+	if (key == NULL)
+	{
+		tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
+		return;
+	}
+
+	cache_file = get_tag_cache_file(source_file);
+	if (tm_source_file_read_tags_cache(source_file, cache_file, key))
+	{
+		g_free(cache_file);
+		g_free(key);
+	}
+	else
+	{
+		tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
+		queue_tag_cache_write(source_file, cache_file, key);
+	}
+}
+
+
+/* cache_key is NULL to not use the tag cache, otherwise the buffer_key of
+ * parse_source_file_cached() which is ignored when not using a buffer */
 static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
-	gsize buf_size, gboolean use_buffer, gboolean update_workspace)
+	gsize buf_size, gboolean use_buffer, gboolean update_workspace, const gchar *cache_key)
 {
 #ifdef TM_DEBUG
 	g_message("Source file updating based on source file %s", source_file->file_name);
@@ -154,9 +350,14 @@ static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
 		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
 	}
-	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
+	if (cache_key)
+		parse_source_file_cached(source_file, text_buf, buf_size, use_buffer, cache_key);
+	else
+		tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
 	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
-	if (update_workspace)
+	if (update_workspace && batch_update_depth > 0)
+		g_hash_table_add(batch_source_files, source_file);
+	else if (update_workspace)
 	{
 #ifdef TM_DEBUG
 		g_message("Updating workspace from source file");
@@ -183,7 +384,7 @@ void tm_workspace_add_source_file(TMSourceFile *source_file)
 	g_return_if_fail(source_file != NULL);
 
 	g_ptr_array_add(theWorkspace->source_files, source_file);
-	update_source_file(source_file, NULL, 0, FALSE, TRUE);
+	update_source_file(source_file, NULL, 0, FALSE, TRUE, "");
 }
 
 
@@ -210,7 +411,67 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file)
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size)
 {
-	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE);
+	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE, NULL);
+}
+
+
+/* Like tm_workspace_update_source_file_buffer() but uses the tag cache if
+ enabled by tm_workspace_set_tag_cache_dir(). Meant for the initial parse of a
+ newly opened file whose buffer still matches the file on disk.
+ @param file_key Describes how the buffer was read from the file, e.g. its
+ encoding, so that tags of differently read buffers aren't mixed up. It must
+ not contain newlines. */
+void tm_workspace_update_source_file_buffer_cached(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, const gchar *file_key)
+{
+	g_return_if_fail(file_key != NULL);
+
+	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE, file_key);
+}
+
+
+/* Starts collecting source file updates so that their tags are merged into the
+ workspace all at once by tm_workspace_end_batch_update(), instead of merging
+ the tags of every file separately into the whole workspace tag array. Until
+ then, the workspace tag arrays don't contain the tags of the updated files.
+ Calls can be nested. */
+void tm_workspace_begin_batch_update(void)
+{
+	if (!batch_source_files)
+		batch_source_files = g_hash_table_new(g_direct_hash, g_direct_equal);
+	batch_update_depth++;
+}
+
+
+/* Merges the tags of the source files updated since the outermost
+ tm_workspace_begin_batch_update() into the workspace. */
+void tm_workspace_end_batch_update(void)
+{
+	GHashTableIter iter;
+	gpointer key;
+	GPtrArray *tags;
+
+	g_return_if_fail(batch_update_depth > 0);
+
+	if (--batch_update_depth > 0 || g_hash_table_size(batch_source_files) == 0)
+		return;
+
+	tags = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, batch_source_files);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		TMSourceFile *source_file = key;
+		guint i;
+
+		for (i = 0; i < source_file->tags_array->len; i++)
+			g_ptr_array_add(tags, source_file->tags_array->pdata[i]);
+	}
+	g_hash_table_remove_all(batch_source_files);
+
+	tm_tags_sort(tags, workspace_tags_sort_attrs, FALSE, FALSE);
+	tm_workspace_merge_tags(&theWorkspace->tags_array, tags);
+	merge_extracted_tags(&theWorkspace->typename_array, tags, TM_GLOBAL_TYPE_MASK);
+	g_ptr_array_free(tags, TRUE);
 }
 
 
@@ -230,6 +491,8 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 	{
 		if (theWorkspace->source_files->pdata[i] == source_file)
 		{
+			if (batch_source_files)
+				g_hash_table_remove(batch_source_files, source_file);
 			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
 			g_ptr_array_remove_index_fast(theWorkspace->source_files, i);
@@ -254,6 +517,9 @@ static void tm_workspace_update(void)
 #endif
 
 	g_ptr_array_set_size(theWorkspace->tags_array, 0);
+	/* all the pending tags are added below */
+	if (batch_source_files)
+		g_hash_table_remove_all(batch_source_files);
 
 #ifdef TM_DEBUG
 	g_message("Total %d objects", theWorkspace->source_files->len);
@@ -300,7 +566,7 @@ void tm_workspace_add_source_files(GPtrArray *source_files)
 		TMSourceFile *source_file = source_files->pdata[i];
 
 		tm_workspace_add_source_file_noupdate(source_file);
-		update_source_file(source_file, NULL, 0, FALSE, FALSE);
+		update_source_file(source_file, NULL, 0, FALSE, FALSE, "");
 	}
 
 	tm_workspace_update();
@@ -616,7 +882,7 @@ gboolean tm_workspace_create_global_tags(const char *pre_process, const char **i
 	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(lang));
 	if (!source_file)
 		goto cleanup;
-	update_source_file(source_file, NULL, 0, FALSE, FALSE);
+	update_source_file(source_file, NULL, 0, FALSE, FALSE, NULL);
 	if (source_file->tags_array->len == 0)
 	{
 		tm_source_file_free(source_file);
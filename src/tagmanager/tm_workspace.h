@@ -67,6 +67,15 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file);
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
 	gsize buf_size);
 
+void tm_workspace_update_source_file_buffer_cached(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, const gchar *file_key);
+
+void tm_workspace_set_tag_cache_dir(const gchar *dir, const gchar *key);
+
+void tm_workspace_begin_batch_update(void);
+
+void tm_workspace_end_batch_update(void);
+
 void tm_workspace_free(void);
 
 
@@ -626,19 +626,19 @@ void tools_create_insert_custom_command_menu_items(void)
 
 
 /* (stolen from bluefish, thanks)
- * Returns number of characters, lines and words in the supplied gchar*.
- * Handles UTF-8 correctly. Input must be properly encoded UTF-8.
+ * Counts characters and words in the @a len bytes at @a text, adding them to @a chars,
+ * @a lines and @a words. @a in_word carries the state over to the next chunk so that
+ * text can be counted in several pieces.
+ * Handles UTF-8 correctly. Input must be properly encoded UTF-8, and chunks must be split
+ * on character boundaries.
  * Words are defined as any characters grouped, separated with spaces. */
-static void word_count(gchar *text, guint *chars, guint *lines, guint *words)
+static void word_count_chunk(const gchar *text, gsize len, guint *chars, guint *lines,
+		guint *words, gboolean *in_word)
 {
-	guint in_word = 0;
+	const gchar *end = text + len;
 	gunichar utext;
 
-	if (! text)
-		return; /* politely refuse to operate on NULL */
-
-	*chars = *words = *lines = 0;
-	while (*text != '\0')
+	while (text < end)
 	{
 		(*chars)++;
 
@@ -653,23 +653,37 @@ static void word_count(gchar *text, guint *chars, guint *lines, guint *words)
 			case ' ':
 			case '\v':
 				mb_word_separator:
-				if (in_word)
+				if (*in_word)
 				{
-					in_word = 0;
+					*in_word = FALSE;
 					(*words)++;
 				}
 				break;
 			default:
-				utext = g_utf8_get_char_validated(text, 2); /* This might be an utf-8 char */
+				/* This might be an utf-8 char */
+				utext = g_utf8_get_char_validated(text, MIN(2, end - text));
 				if (g_unichar_isspace(utext)) /* Unicode encoded space? */
 					goto mb_word_separator;
 				if (g_unichar_isgraph(utext)) /* Is this something printable? */
-					in_word = 1;
+					*in_word = TRUE;
 				break;
 		}
 		/* Even if the current char is 2 bytes, this will iterate correctly. */
 		text = g_utf8_next_char(text);
 	}
+}
+
+
+/* Returns number of characters, lines and words in the supplied chunks of text,
+ * see word_count_chunk(). */
+static void word_count(const gchar *text1, gsize len1, const gchar *text2, gsize len2,
+		guint *chars, guint *lines, guint *words)
+{
+	gboolean in_word = FALSE;
+
+	*chars = *words = *lines = 0;
+	word_count_chunk(text1, len1, chars, lines, words, &in_word);
+	word_count_chunk(text2, len2, chars, lines, words, &in_word);
 
 	/* Capture last word, if there's no whitespace at the end of the file. */
 	if (in_word)
@@ -685,7 +699,6 @@ void tools_word_count(void)
 	GtkWidget *dialog, *label, *vbox, *table;
 	GeanyDocument *doc;
 	guint chars = 0, lines = 0, words = 0;
-	gchar *text;
 	const gchar *range;
 
 	doc = document_get_current();
@@ -699,16 +712,22 @@ void tools_word_count(void)
 
 	if (sci_has_selection(doc->editor->sci))
 	{
-		text = sci_get_selection_contents(doc->editor->sci);
+		gchar *text = sci_get_selection_contents(doc->editor->sci);
+
+		word_count(text, strlen(text), NULL, 0, &chars, &lines, &words);
+		g_free(text);
 		range = _("selection");
 	}
 	else
 	{
-		text = sci_get_contents(doc->editor->sci, -1);
+		const gchar *text1, *text2;
+		gint len1, len2;
+
+		/* count straight from Scintilla's buffer rather than copying the whole document */
+		sci_get_text_segments(doc->editor->sci, &text1, &len1, &text2, &len2);
+		word_count(text1, (gsize) len1, text2, (gsize) len2, &chars, &lines, &words);
 		range = _("whole document");
 	}
-	word_count(text, &chars, &lines, &words);
-	g_free(text);
 
 	table = gtk_table_new(4, 2, FALSE);
 	gtk_table_set_row_spacings(GTK_TABLE(table), 5);
@@ -233,6 +233,8 @@ typedef enum
 
 gint utils_get_line_endings(const gchar* buffer, gsize size);
 
+gint utils_get_line_endings_and_count(const gchar* buffer, gsize size, gsize *n_lines);
+
 gboolean utils_isbrace(gchar c, gboolean include_angles);
 
 gboolean utils_is_opening_brace(gchar c, gboolean include_angles);
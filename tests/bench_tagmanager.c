@@ -0,0 +1,446 @@
+/*
+ *      bench_tagmanager.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2022 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Tag manager benchmarks, run with "make bench".
+ *
+ * Every measurement is printed as one JSON object per line on stdout so that
+ * results of two runs can be compared with standard tools. The reported time
+ * is the best of all runs of the measurement.
+ */
+
+#include "tm_workspace.h"
+#include "tm_source_file.h"
+#include "tm_parser.h"
+#include "tm_tag.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+
+typedef void (*CorpusFunc)(GString *str, guint i);
+
+typedef struct
+{
+	const gchar *lang;
+	const gchar *ext;
+	CorpusFunc generate;
+} CorpusLang;
+
+
+static gint opt_runs = 3;
+static gint opt_units = 20000;
+static gint opt_max_tags = 1000000;
+static gint opt_queries = 1000;
+
+static GOptionEntry entries[] =
+{
+	{ "runs", 'r', 0, G_OPTION_ARG_INT, &opt_runs, "Number of runs of each measurement", "N" },
+	{ "units", 'u', 0, G_OPTION_ARG_INT, &opt_units, "Number of units in the generated parser corpora", "N" },
+	{ "max-tags", 'm', 0, G_OPTION_ARG_INT, &opt_max_tags, "Largest synthetic workspace size (up to 5000000)", "N" },
+	{ "queries", 'q', 0, G_OPTION_ARG_INT, &opt_queries, "Number of workspace lookups to average", "N" },
+	{ NULL }
+};
+
+static const guint workspace_sizes[] = { 10000, 100000, 1000000, 5000000 };
+
+/* keep in sync with workspace_tags_sort_attrs in tm_workspace.c */
+static TMTagAttrType workspace_sort_attrs[] =
+{
+	tm_tag_attr_name_t, tm_tag_attr_file_t, tm_tag_attr_line_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+/* keep in sync with global_tags_sort_attrs in tm_workspace.c */
+static TMTagAttrType global_sort_attrs[] =
+{
+	tm_tag_attr_name_t,
+	tm_tag_attr_type_t, tm_tag_attr_scope_t, tm_tag_attr_arglist_t, 0
+};
+
+
+static void corpus_c(GString *str, guint i)
+{
+	g_string_append_printf(str,
+		"struct s%u\n{\n\tint a%u;\n\tchar *b;\n};\n\n"
+		"static int func_%u(int x, struct s%u *p)\n{\n\treturn x + p->a%u;\n}\n\n",
+		i, i, i, i, i);
+}
+
+
+static void corpus_cpp(GString *str, guint i)
+{
+	g_string_append_printf(str,
+		"namespace ns%u\n{\n"
+		"class Class%u : public Base\n{\npublic:\n"
+		"\tint member_%u;\n\tvoid method_%u(int x, const char *y);\n};\n}\n\n",
+		i, i, i, i);
+}
+
+
+static void corpus_python(GString *str, guint i)
+{
+	g_string_append_printf(str,
+		"class Class%u(object):\n"
+		"    def method_%u(self, x):\n        return x\n\n"
+		"def func_%u(a, b=%u):\n    return a + b\n\n",
+		i, i, i, i);
+}
+
+
+static void corpus_js(GString *str, guint i)
+{
+	g_string_append_printf(str,
+		"function func_%u(a, b) {\n\treturn a + b;\n}\n"
+		"var obj_%u = {\n\tprop_%u: 1,\n\tmeth_%u: function() { return 2; }\n};\n\n",
+		i, i, i, i);
+}
+
+
+static const CorpusLang corpus_langs[] =
+{
+	{ "C", "c", corpus_c },
+	{ "C++", "cpp", corpus_cpp },
+	{ "Python", "py", corpus_python },
+	{ "JavaScript", "js", corpus_js }
+};
+
+
+static void emit_result(const gchar *benchmark, const gchar *variant, guint n,
+		gdouble seconds, gsize bytes)
+{
+	printf("{\"benchmark\": \"%s\", \"variant\": \"%s\", \"n\": %u, \"seconds\": %.9f",
+		benchmark, variant, n, seconds);
+	if (bytes > 0)
+		printf(", \"bytes\": %" G_GSIZE_FORMAT, bytes);
+	printf(", \"runs\": %d}\n", opt_runs);
+	fflush(stdout);
+}
+
+
+static gchar *write_corpus(const gchar *dir, const CorpusLang *cl, guint units, gsize *len)
+{
+	GString *str = g_string_sized_new(units * 128);
+	gchar *name = g_strconcat("corpus.", cl->ext, NULL);
+	gchar *path = g_build_filename(dir, name, NULL);
+	guint i;
+
+	for (i = 0; i < units; i++)
+		cl->generate(str, i);
+
+	if (!g_file_set_contents(path, str->str, str->len, NULL))
+		g_error("Cannot write %s", path);
+
+	*len = str->len;
+	g_string_free(str, TRUE);
+	g_free(name);
+	return path;
+}
+
+
+static void bench_parsers(const gchar *dir)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(corpus_langs); i++)
+	{
+		const CorpusLang *cl = &corpus_langs[i];
+		TMSourceFile *source_file;
+		gchar *path, *contents;
+		gsize len;
+		gdouble best = G_MAXDOUBLE;
+		guint tag_count = 0;
+		gint run;
+
+		path = write_corpus(dir, cl, opt_units, &len);
+		g_file_get_contents(path, &contents, &len, NULL);
+		source_file = tm_source_file_new(path, cl->lang);
+
+		for (run = 0; run < opt_runs; run++)
+		{
+			GTimer *timer = g_timer_new();
+
+			tm_source_file_parse(source_file, (guchar *) contents, len, TRUE);
+			best = MIN(best, g_timer_elapsed(timer, NULL));
+			g_timer_destroy(timer);
+		}
+		tag_count = source_file->tags_array->len;
+		emit_result("parse", cl->lang, tag_count, best, len);
+
+		tm_source_file_free(source_file);
+		g_unlink(path);
+		g_free(contents);
+		g_free(path);
+	}
+}
+
+
+/* Creates n_tags function tags spread over n_files source files. The tags are
+ * owned by the source files like in a real workspace. */
+static GPtrArray *create_workspace_tags(guint n_tags, guint n_files, GPtrArray *files,
+		GRand *rand)
+{
+	GPtrArray *tags = g_ptr_array_sized_new(n_tags);
+	guint i;
+
+	for (i = 0; i < n_files; i++)
+		g_ptr_array_add(files, tm_source_file_new(NULL, "C"));
+
+	for (i = 0; i < n_tags; i++)
+	{
+		TMSourceFile *file = files->pdata[i % n_files];
+		TMTag *tag = tm_tag_new();
+
+		tag->name = g_strdup_printf("sym_%08x", g_rand_int(rand));
+		tag->type = tm_tag_function_t;
+		tag->file = file;
+		tag->line = i / n_files + 1;
+		tag->arglist = g_strdup("(int a, char *b)");
+		tag->lang = TM_PARSER_C;
+		g_ptr_array_add(file->tags_array, tag);
+		g_ptr_array_add(tags, tag);
+	}
+	return tags;
+}
+
+
+static GPtrArray *copy_tags(GPtrArray *tags)
+{
+	GPtrArray *copy = g_ptr_array_sized_new(tags->len);
+
+	g_ptr_array_set_size(copy, tags->len);
+	memcpy(copy->pdata, tags->pdata, tags->len * sizeof(gpointer));
+	return copy;
+}
+
+
+static void bench_tag_arrays(void)
+{
+	guint s;
+
+	for (s = 0; s < G_N_ELEMENTS(workspace_sizes); s++)
+	{
+		guint n = workspace_sizes[s];
+		guint n_files = MAX(n / 1000, 2);
+		GPtrArray *files, *tags, *sorted, *small;
+		GRand *rand;
+		TMSourceFile *small_file;
+		gdouble sort_best = G_MAXDOUBLE, merge_best = G_MAXDOUBLE, remove_best = G_MAXDOUBLE;
+		gint run;
+
+		if (n > (guint) opt_max_tags)
+			break;
+
+		files = g_ptr_array_new();
+		rand = g_rand_new_with_seed(n);
+		tags = create_workspace_tags(n, n_files, files, rand);
+
+		/* one extra file with 1% of the workspace size, like opening a document */
+		small = create_workspace_tags(MAX(n / 100, 1), 1, files, rand);
+		small_file = files->pdata[files->len - 1];
+		tm_tags_sort(small, workspace_sort_attrs, TRUE, FALSE);
+
+		sorted = copy_tags(tags);
+		tm_tags_sort(sorted, workspace_sort_attrs, TRUE, FALSE);
+
+		for (run = 0; run < opt_runs; run++)
+		{
+			GPtrArray *copy = copy_tags(tags);
+			GPtrArray *merged;
+			GTimer *timer = g_timer_new();
+
+			tm_tags_sort(copy, workspace_sort_attrs, TRUE, FALSE);
+			sort_best = MIN(sort_best, g_timer_elapsed(timer, NULL));
+			g_ptr_array_free(copy, TRUE);
+
+			g_timer_start(timer);
+			merged = tm_tags_merge(sorted, small, workspace_sort_attrs, FALSE);
+			merge_best = MIN(merge_best, g_timer_elapsed(timer, NULL));
+
+			g_timer_start(timer);
+			tm_tags_remove_file_tags(small_file, merged);
+			remove_best = MIN(remove_best, g_timer_elapsed(timer, NULL));
+
+			g_ptr_array_free(merged, TRUE);
+			g_timer_destroy(timer);
+		}
+		emit_result("tags_sort", "workspace", n, sort_best, 0);
+		emit_result("tags_merge", "workspace", n, merge_best, 0);
+		emit_result("tags_remove_file_tags", "workspace", n, remove_best, 0);
+
+		g_ptr_array_free(sorted, TRUE);
+		g_ptr_array_free(small, TRUE);
+		g_ptr_array_free(tags, TRUE);
+		g_ptr_array_foreach(files, (GFunc) tm_source_file_free, NULL);
+		g_ptr_array_free(files, TRUE);
+		g_rand_free(rand);
+	}
+}
+
+
+static void bench_workspace_queries(const gchar *dir)
+{
+	const CorpusLang *cl = &corpus_langs[1];
+	TMSourceFile *source_file;
+	gchar *path, *contents;
+	gsize len;
+	GTimer *timer;
+	guint n_tags;
+	gint i;
+
+	path = write_corpus(dir, cl, opt_units, &len);
+	g_file_get_contents(path, &contents, &len, NULL);
+	source_file = tm_source_file_new(path, cl->lang);
+	tm_workspace_add_source_file_noupdate(source_file);
+	tm_workspace_update_source_file_buffer(source_file, (guchar *) contents, len);
+	n_tags = tm_get_workspace()->tags_array->len;
+
+	timer = g_timer_new();
+	for (i = 0; i < opt_queries; i++)
+	{
+		gchar *prefix = g_strdup_printf("method_%d", i % opt_units);
+		GPtrArray *found = tm_workspace_find_prefix(prefix, source_file->lang, 30);
+
+		if (found)
+			g_ptr_array_free(found, TRUE);
+		g_free(prefix);
+	}
+	emit_result("find_prefix", cl->lang, n_tags, g_timer_elapsed(timer, NULL) / opt_queries, 0);
+
+	g_timer_start(timer);
+	for (i = 0; i < opt_queries; i++)
+	{
+		gchar *name = g_strdup_printf("Class%d", i % opt_units);
+		GPtrArray *found = tm_workspace_find_scope_members(source_file, name,
+			FALSE, FALSE, "", FALSE);
+
+		if (found)
+			g_ptr_array_free(found, TRUE);
+		g_free(name);
+	}
+	emit_result("find_scope_members", cl->lang, n_tags, g_timer_elapsed(timer, NULL) / opt_queries, 0);
+
+	g_timer_destroy(timer);
+	tm_workspace_remove_source_file(source_file);
+	tm_source_file_free(source_file);
+	g_unlink(path);
+	g_free(contents);
+	g_free(path);
+}
+
+
+static void reset_global_tags(void)
+{
+	/* the workspace is a singleton handed out read-only; the benchmark is its
+	 * only user, so it may drop the loaded global tags between measurements */
+	TMWorkspace *workspace = (TMWorkspace *) tm_get_workspace();
+
+	tm_tags_array_free(workspace->global_tags, TRUE);
+	workspace->global_tags = g_ptr_array_new();
+	g_ptr_array_free(workspace->global_typename_array, TRUE);
+	workspace->global_typename_array = g_ptr_array_new();
+}
+
+
+static void bench_global_tags(const gchar *dir)
+{
+	gchar *path = g_build_filename(dir, "global.c.tags", NULL);
+	guint s;
+
+	for (s = 0; s < G_N_ELEMENTS(workspace_sizes); s++)
+	{
+		guint n = workspace_sizes[s];
+		GPtrArray *files, *tags;
+		GRand *rand;
+		gdouble best = G_MAXDOUBLE;
+		gint run;
+
+		if (n > (guint) opt_max_tags)
+			break;
+
+		files = g_ptr_array_new();
+		rand = g_rand_new_with_seed(n);
+		tags = create_workspace_tags(n, 1, files, rand);
+		tm_tags_sort(tags, global_sort_attrs, TRUE, FALSE);
+		if (!tm_source_file_write_tags_file(path, tags))
+			g_error("Cannot write %s", path);
+		g_ptr_array_free(tags, TRUE);
+		g_ptr_array_foreach(files, (GFunc) tm_source_file_free, NULL);
+		g_ptr_array_free(files, TRUE);
+		g_rand_free(rand);
+
+		for (run = 0; run < opt_runs; run++)
+		{
+			GTimer *timer = g_timer_new();
+
+			tm_workspace_load_global_tags(path, TM_PARSER_C);
+			best = MIN(best, g_timer_elapsed(timer, NULL));
+			g_timer_destroy(timer);
+			reset_global_tags();
+		}
+		emit_result("load_global_tags", "C", n, best, 0);
+	}
+	g_unlink(path);
+	g_free(path);
+}
+
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *dir;
+
+	context = g_option_context_new("- tag manager benchmarks");
+	g_option_context_add_main_entries(context, entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error))
+	{
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+	opt_runs = MAX(opt_runs, 1);
+	opt_units = MAX(opt_units, 1);
+	opt_queries = MAX(opt_queries, 1);
+
+	dir = g_dir_make_tmp("geany-bench-XXXXXX", &error);
+	if (!dir)
+	{
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+
+	/* initializes ctags */
+	tm_get_workspace();
+
+	bench_parsers(dir);
+	bench_tag_arrays();
+	bench_workspace_queries(dir);
+	bench_global_tags(dir);
+
+	tm_workspace_free();
+	g_rmdir(dir);
+	g_free(dir);
+	return 0;
+}
@@ -408,6 +408,33 @@ void test_utils_strv_shorten_file_list(void)
 	g_strfreev(data);
 }
 
+#define EOL_FOR(buf, size, n_lines) \
+	utils_get_eol_char(utils_get_line_endings_and_count(buf, size, n_lines))
+static void test_utils_get_line_endings(void)
+{
+	gsize n_lines;
+
+	g_assert_cmpstr(EOL_FOR("", 0, &n_lines), ==, "\n");
+	g_assert_cmpuint(n_lines, ==, 1);
+
+	g_assert_cmpstr(EOL_FOR("a\nb\n", 4, &n_lines), ==, "\n");
+	g_assert_cmpuint(n_lines, ==, 3);
+
+	g_assert_cmpstr(EOL_FOR("a\r\nb\r\nc\n", 9, &n_lines), ==, "\r\n");
+	g_assert_cmpuint(n_lines, ==, 4);
+
+	g_assert_cmpstr(EOL_FOR("a\rb\rc", 5, &n_lines), ==, "\r");
+	g_assert_cmpuint(n_lines, ==, 3);
+
+	/* a trailing CR is a line ending on its own */
+	g_assert_cmpstr(EOL_FOR("a\r\nb\r", 5, &n_lines), ==, "\r\n");
+	g_assert_cmpuint(n_lines, ==, 3);
+
+	/* embedded NULs don't stop the scan */
+	g_assert_cmpstr(EOL_FOR("a\0\rb\0\rc", 7, NULL), ==, "\r");
+}
+#undef EOL_FOR
+
 int main(int argc, char **argv)
 {
 	g_test_init(&argc, &argv, NULL);
@@ -416,6 +443,7 @@ int main(int argc, char **argv)
 	UTIL_TEST_ADD("strv_find_common_prefix", test_utils_strv_find_common_prefix);
 	UTIL_TEST_ADD("strv_find_lcs", test_utils_strv_find_lcs);
 	UTIL_TEST_ADD("strv_shorten_file_list", test_utils_strv_shorten_file_list);
+	UTIL_TEST_ADD("get_line_endings", test_utils_get_line_endings);
 
 	return g_test_run();
 }